@@ -0,0 +1,92 @@
+#ifndef REGEX_FA_BENCH_GENERATORS_HPP
+#define REGEX_FA_BENCH_GENERATORS_HPP
+
+#include <numeric>
+#include <random>
+
+#include "regex-fa/dfa.hpp"
+#include "regex-fa/nfa.hpp"
+
+namespace regex_fa::bench {
+
+/**
+ * Terminal i of an alphabet of up to 256 single-byte terminals, "a" first.
+ */
+[[nodiscard]] inline Terminal NthTerminal(size_t i) {
+  assert(i < 256);
+  return Terminal(1, static_cast<char>((i + 'a') % 256));
+}
+
+/**
+ * (a|b)*a(a|b)^n, n + 2 states. Its minimal Dfa has 2^(n+1) states.
+ */
+[[nodiscard]] inline Nfa BlowupNfa(size_t n) {
+  auto nfa_table = Nfa::NfaTable{};
+  nfa_table[0] = {{"a", {0, 1}}, {"b", {0}}};
+  for (StateId u = 1; u <= n; ++u) {
+    nfa_table[u] = {{"a", {u + 1}}, {"b", {u + 1}}};
+  }
+  nfa_table[n + 1] = {};
+  return {std::move(nfa_table), 0, {n + 1}};
+}
+
+/**
+ * a^n, states 0..n, n final.
+ */
+[[nodiscard]] inline Dfa ChainDfa(size_t n) {
+  auto dfa_table = Dfa::DfaTable{};
+  for (StateId u = 0; u < n; ++u) {
+    dfa_table[u] = {{"a", u + 1}};
+  }
+  dfa_table[n] = {};
+  return {std::move(dfa_table), 0, {n}};
+}
+
+/**
+ * n states, each with out_degree distinct terminals out of alphabet_size
+ * going to uniformly random states. Each state is final with probability
+ * 1/2. Equal arguments give equal Dfas.
+ */
+[[nodiscard]] inline Dfa RandomSparseDfa(size_t n, size_t alphabet_size,
+                                         size_t out_degree, uint64_t seed) {
+  assert(0 < n && out_degree <= alphabet_size);
+  auto e = std::mt19937_64{seed};
+  auto target = std::uniform_int_distribution<StateId>{0, n - 1};
+  auto terminals = std::vector<size_t>(alphabet_size);
+  std::iota(terminals.begin(), terminals.end(), 0);
+
+  auto dfa_table = Dfa::DfaTable{};
+  auto f = States{};
+  for (StateId u = 0; u < n; ++u) {
+    auto &trans_table = dfa_table[u];
+    // Partial Fisher-Yates: the first out_degree terminals are a sample.
+    for (size_t i = 0; i < out_degree; ++i) {
+      std::swap(terminals[i],
+                terminals[std::uniform_int_distribution<size_t>{
+                    i, alphabet_size - 1}(e)]);
+      trans_table.emplace(NthTerminal(terminals[i]), target(e));
+    }
+    if (e() % 2 == 0) {
+      f.emplace(u);
+    }
+  }
+  return {std::move(dfa_table), 0, std::move(f)};
+}
+
+/**
+ * Complete Dfa with n states over alphabet_size terminals, every transition
+ * to a uniformly random state.
+ */
+[[nodiscard]] inline Dfa DenseAlphabetDfa(size_t n, size_t alphabet_size,
+                                          uint64_t seed) {
+  return RandomSparseDfa(n, alphabet_size, alphabet_size, seed);
+}
+
+/**
+ * The same automaton as an Nfa, so ToDfa() can be run on any family.
+ */
+[[nodiscard]] inline Nfa ToNfa(const Dfa &dfa) { return Nfa{dfa.ToFlatDfa()}; }
+
+}  // namespace regex_fa::bench
+
+#endif  // REGEX_FA_BENCH_GENERATORS_HPP
@@ -0,0 +1,207 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "generators.hpp"
+
+using namespace regex_fa;
+
+//-----------------------------------------------------------------------------
+// Every allocation of the process goes through here to be counted.
+namespace {
+
+std::atomic<size_t> alloc_count{0};
+std::atomic<size_t> alloc_bytes{0};
+
+}  // namespace
+
+void *operator new(std::size_t size) {
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void *p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+//-----------------------------------------------------------------------------
+
+namespace {
+
+uint64_t seed = 42;
+
+/**
+ * Peak resident set size of the process so far, 0 where unknown.
+ */
+[[nodiscard]] double PeakRssKb() {
+#if defined(__linux__) || defined(__APPLE__)
+  auto usage = rusage{};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return static_cast<double>(usage.ru_maxrss) / 1024;  // bytes
+#else
+  return static_cast<double>(usage.ru_maxrss);
+#endif
+#else
+  return 0;
+#endif
+}
+
+/**
+ * A family of automata of growing size. nfa(n) and dfa(n) accept the same
+ * language.
+ */
+struct Family {
+  std::string name;
+  std::vector<int64_t> sizes;
+  std::function<Nfa(size_t)> nfa;
+  std::function<Dfa(size_t)> dfa;
+};
+
+[[nodiscard]] std::vector<Family> GetFamilies() {
+  return {
+      {"blowup",
+       {4, 8, 12, 16},
+       bench::BlowupNfa,
+       [](size_t n) { return bench::BlowupNfa(n).ToDfa(); }},
+      {"chain",
+       {1 << 10, 1 << 14, 1 << 18},
+       [](size_t n) { return bench::ToNfa(bench::ChainDfa(n)); },
+       bench::ChainDfa},
+      {"sparse",
+       {1 << 10, 1 << 13, 1 << 16},
+       [](size_t n) {
+         return bench::ToNfa(bench::RandomSparseDfa(n, 16, 3, seed));
+       },
+       [](size_t n) { return bench::RandomSparseDfa(n, 16, 3, seed); }},
+      {"dense",
+       {1 << 6, 1 << 9, 1 << 12},
+       [](size_t n) {
+         return bench::ToNfa(bench::DenseAlphabetDfa(n, 256, seed));
+       },
+       [](size_t n) { return bench::DenseAlphabetDfa(n, 256, seed); }},
+  };
+}
+
+/**
+ * Times run(make()) with a fresh input every iteration, so caches such as
+ * Dfa::GetIndex() are built inside the timed region each time.
+ * Reports per iteration allocations and allocated bytes, the number of
+ * states of the result, and the peak RSS of the process so far.
+ */
+template <typename Make, typename Run>
+void Measure(benchmark::State &state, Make &&make, Run &&run) {
+  size_t allocs = 0;
+  size_t bytes = 0;
+  size_t states = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      const auto input = make();
+      const auto allocs_before = alloc_count.load(std::memory_order_relaxed);
+      const auto bytes_before = alloc_bytes.load(std::memory_order_relaxed);
+      state.ResumeTiming();
+
+      const auto res = run(input);
+
+      state.PauseTiming();
+      allocs += alloc_count.load(std::memory_order_relaxed) - allocs_before;
+      bytes += alloc_bytes.load(std::memory_order_relaxed) - bytes_before;
+      states = res.GetDfaTable().size();
+      benchmark::DoNotOptimize(res);
+    }
+    state.ResumeTiming();
+  }
+  using Counter = benchmark::Counter;
+  state.counters["allocs"] =
+      Counter(static_cast<double>(allocs), Counter::kAvgIterations);
+  state.counters["alloc_bytes"] =
+      Counter(static_cast<double>(bytes), Counter::kAvgIterations);
+  state.counters["states"] = static_cast<double>(states);
+  state.counters["peak_rss_kb"] = PeakRssKb();
+}
+
+/**
+ * A Dfa equal to dfa with its own, not yet built, index.
+ */
+[[nodiscard]] Dfa Fresh(const Dfa &dfa) {
+  return {dfa.GetDfaTable(), dfa.GetS(), dfa.GetF(), dfa.GetAcceptTable()};
+}
+
+void RegisterBenchmarks() {
+  // Outlives the benchmarks, which refer to it.
+  static const auto families = GetFamilies();
+  for (const auto &family : families) {
+    auto Register = [&family](const std::string &op, auto &&fn) {
+      auto *bench = benchmark::RegisterBenchmark(
+          (op + "/" + family.name).c_str(), std::forward<decltype(fn)>(fn));
+      for (auto size : family.sizes) {
+        bench->Arg(size);
+      }
+      bench->Unit(benchmark::kMillisecond);
+    };
+
+    Register("ToDfa", [&family](benchmark::State &state) {
+      const auto n = static_cast<size_t>(state.range(0));
+      Measure(
+          state, [&] { return family.nfa(n); },
+          [](const Nfa &nfa) { return nfa.ToDfa(); });
+    });
+    Register("Minimize", [&family](benchmark::State &state) {
+      const auto dfa = family.dfa(static_cast<size_t>(state.range(0)));
+      Measure(
+          state, [&] { return Fresh(dfa); },
+          [](const Dfa &dfa) { return dfa.Minimize(); });
+    });
+    Register("ReorderStates", [&family](benchmark::State &state) {
+      const auto dfa = family.dfa(static_cast<size_t>(state.range(0)));
+      Measure(
+          state, [&] { return Fresh(dfa); },
+          [](const Dfa &dfa) { return dfa.ReorderStates(); });
+    });
+  }
+}
+
+}  // namespace
+
+/**
+ * Google Benchmark flags apply, output defaults to JSON on stdout.
+ * --seed=N changes the seed of the random families.
+ */
+int main(int argc, char *argv[]) {
+  auto args = std::vector<char *>{};
+  auto has_format = false;
+  for (int i = 0; i < argc; ++i) {
+    const auto arg = std::string_view{argv[i]};
+    if (arg.starts_with("--seed=")) {
+      seed = std::stoull(std::string{arg.substr(7)});
+      continue;
+    }
+    has_format = has_format || arg.starts_with("--benchmark_format=");
+    args.emplace_back(argv[i]);
+  }
+  auto json = std::string{"--benchmark_format=json"};
+  if (!has_format) {
+    args.emplace_back(json.data());
+  }
+
+  auto args_count = static_cast<int>(args.size());
+  benchmark::Initialize(&args_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) {
+    return 1;
+  }
+  RegisterBenchmarks();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
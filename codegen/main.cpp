@@ -0,0 +1,82 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "regex-fa/codegen.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+constexpr std::string_view kUsage =
+    "usage: regex_fa_codegen [--name NAME] [--namespace NAMESPACE]\n"
+    "                        [--sample FILE] [--output FILE] PATTERN\n"
+    "Writes a header with NAMEAccepts and NAMELongestMatch for PATTERN.\n"
+    "States hot while scanning the sample file are laid out first.\n";
+
+[[nodiscard]] std::string ReadFile(const std::string &path) {
+  auto file = std::ifstream{path, std::ios::binary};
+  if (!file) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  auto buffer = std::ostringstream{};
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  auto options = CodegenOptions{};
+  auto output = std::string{};
+  auto pattern = std::optional<std::string>{};
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const auto arg = std::string_view{argv[i]};
+      auto Value = [&]() -> std::string {
+        if (i + 1 == argc) {
+          throw std::runtime_error(std::string{arg} + " needs a value");
+        }
+        return argv[++i];
+      };
+      if (arg == "--name") {
+        options.name = Value();
+      } else if (arg == "--namespace") {
+        options.nameSpace = Value();
+      } else if (arg == "--sample") {
+        options.sample = ReadFile(Value());
+      } else if (arg == "--output") {
+        output = Value();
+      } else if (arg == "--help" || pattern.has_value()) {
+        std::cerr << kUsage;
+        return arg == "--help" ? 0 : 1;
+      } else {
+        pattern = arg;
+      }
+    }
+    if (!pattern.has_value()) {
+      std::cerr << kUsage;
+      return 1;
+    }
+
+    const auto dfa =
+        RegexToNfa(pattern.value()).ToDfa().Minimize().ReorderStates();
+    const auto code = Codegen{dfa, std::move(options)}.Generate();
+    if (output.empty()) {
+      std::cout << code;
+    } else {
+      auto file = std::ofstream{output, std::ios::binary};
+      file << code;
+      if (!file) {
+        throw std::runtime_error("cannot write " + output);
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "regex_fa_codegen: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
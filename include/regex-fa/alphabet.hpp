@@ -0,0 +1,158 @@
+#ifndef REGEX_FA_ALPHABET_HPP
+#define REGEX_FA_ALPHABET_HPP
+
+#include "fa-include.hpp"
+#include "refinable-partition.hpp"
+
+namespace regex_fa {
+
+using SymbolId = uint32_t;
+using ClassId = uint32_t;
+
+/**
+ * Terminals grouped into classes, each class sorted, classes ordered by their
+ * smallest terminal.
+ */
+using TerminalClasses = std::vector<std::vector<Terminal>>;
+
+/**
+ * Interned alphabet, Terminal <-> SymbolId.
+ * SymbolIds are contiguous from 0 in insertion order.
+ */
+class SymbolTable {
+ public:
+  static constexpr SymbolId kNoSymbol = std::numeric_limits<SymbolId>::max();
+
+ private:
+  /**
+   * Lets ids_ be searched by std::string_view without building a Terminal.
+   */
+  struct TerminalHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view terminal) const {
+      return std::hash<std::string_view>{}(terminal);
+    }
+  };
+
+  std::vector<Terminal> terminals_;
+  std::unordered_map<Terminal, SymbolId, TerminalHash, std::equal_to<>> ids_;
+
+ public:
+  SymbolTable() = default;
+
+  /**
+   * Intern terminals in sorted order, so equal sets give equal tables.
+   */
+  explicit SymbolTable(const Terminals &terminals) {
+    auto sorted = std::vector<Terminal>{terminals.begin(), terminals.end()};
+    std::ranges::sort(sorted);
+    for (const auto &terminal : sorted) {
+      Intern(terminal);
+    }
+  }
+
+  /**
+   * Get id of terminal, adding it if it is new.
+   */
+  SymbolId Intern(const Terminal &terminal) {
+    auto [it, inserted] =
+        ids_.try_emplace(terminal, static_cast<SymbolId>(terminals_.size()));
+    if (inserted) {
+      terminals_.emplace_back(terminal);
+    }
+    return it->second;
+  }
+
+  /**
+   * @return Id of terminal, or kNoSymbol if it is not interned.
+   */
+  [[nodiscard]] SymbolId Find(std::string_view terminal) const {
+    auto it = ids_.find(terminal);
+    return it == ids_.end() ? kNoSymbol : it->second;
+  }
+
+  [[nodiscard]] const Terminal &GetTerminal(SymbolId symbol) const {
+    assert(symbol < terminals_.size());
+    return terminals_[symbol];
+  }
+
+  [[nodiscard]] const std::vector<Terminal> &GetTerminals() const {
+    return terminals_;
+  }
+
+  [[nodiscard]] size_t Size() const { return terminals_.size(); }
+};
+
+/**
+ * Alphabet equivalence classes: symbols 0..n-1 grouped so that symbols of a
+ * class go to the same targets from every state. An automaton only needs one
+ * column per class instead of one per symbol.
+ * Starts with a single class. Each Refine separates the symbols that one
+ * state sends to different targets.
+ */
+class SymbolClasses {
+ public:
+  /**
+   * (target, symbol), a transition of one state.
+   */
+  using Edge = std::pair<uint64_t, SymbolId>;
+
+ private:
+  RefinablePartition partition_;
+
+ public:
+  explicit SymbolClasses(size_t symbol_count)
+      : partition_(std::vector<uint32_t>(symbol_count, 0), 1) {}
+
+  /**
+   * @param edges All transitions of one state, in any order. Symbols that are
+   * not in edges have no transition there. Sorted in place.
+   */
+  void Refine(std::vector<Edge> &edges) {
+    std::ranges::sort(edges);
+    for (auto it = edges.begin(); it != edges.end();) {
+      const auto target = it->first;
+      for (; it != edges.end() && it->first == target; ++it) {
+        partition_.Mark(it->second);
+      }
+      partition_.SplitMarked([](auto, auto) {});
+    }
+  }
+
+  [[nodiscard]] size_t Size() const { return partition_.BlockCount(); }
+
+  /**
+   * Class of every symbol, classes numbered by their smallest symbol.
+   */
+  [[nodiscard]] std::vector<ClassId> GetClasses() const {
+    constexpr auto kNoClass = std::numeric_limits<ClassId>::max();
+    auto new_ids = std::vector<ClassId>(Size(), kNoClass);
+    auto res = std::vector<ClassId>(partition_.Size());
+    ClassId free_id = 0;
+    for (SymbolId t = 0; t < res.size(); ++t) {
+      auto &new_id = new_ids[partition_.BlockOf(t)];
+      if (new_id == kNoClass) {
+        new_id = free_id++;
+      }
+      res[t] = new_id;
+    }
+    return res;
+  }
+
+  /**
+   * Classes as terminals, for a SymbolTable interned in sorted order.
+   */
+  [[nodiscard]] TerminalClasses GetTerminalClasses(
+      const SymbolTable &symbols) const {
+    auto res = TerminalClasses(Size());
+    const auto classes = GetClasses();
+    for (SymbolId t = 0; t < classes.size(); ++t) {
+      res[classes[t]].emplace_back(symbols.GetTerminal(t));
+    }
+    return res;
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_ALPHABET_HPP
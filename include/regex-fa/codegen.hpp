@@ -0,0 +1,207 @@
+#ifndef REGEX_FA_CODEGEN_HPP
+#define REGEX_FA_CODEGEN_HPP
+
+#include "dfa.hpp"
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+struct CodegenOptions {
+  std::string name = "Match";  // prefix of the generated functions
+  std::string nameSpace{};     // empty for the global namespace
+  std::string sample{};        // input used to find hot states, may be empty
+};
+
+/**
+ * Emits a direct-coded matcher for a Dfa as a self-contained C++ header.
+ * Every state becomes a labeled block that tests for the end of input and
+ * dispatches on the next byte with a switch of gotos, so matching reads no
+ * table. Bytes are grouped by target state, the largest group is the
+ * default case.
+ * Blocks are laid out hottest first: by visit count while scanning
+ * CodegenOptions::sample, restarting from the start state at the byte where
+ * the Dfa dies, then by state id. Call ReorderStates() first so that ties
+ * and the no-sample case fall back to bfs order.
+ * Direct code pays off when the next state is predictable, e.g. a scan that
+ * stays in one state over most of the input; on random input the branches
+ * mispredict and DenseDfaView's branch-free table walk is faster.
+ * Only single-byte Terminals are emitted, as in DenseDfa.
+ * The header defines
+ *   bool <name>Accepts(std::string_view input)
+ *   std::optional<size_t> <name>LongestMatch(std::string_view input)
+ * with the semantics of DenseDfaView.
+ */
+class Codegen {
+ private:
+  static constexpr StateId kDead = std::numeric_limits<StateId>::max();
+
+  struct State {
+    StateId id{};
+    bool accepting{};
+    std::array<StateId, 256> next{};  // kDead for missing transitions
+  };
+
+  std::vector<State> states_;  // emission order, start state first
+  CodegenOptions options_;
+
+ public:
+  Codegen(const Dfa &dfa, CodegenOptions options)
+      : options_(std::move(options)) {
+    auto ids = std::vector<StateId>{};
+    for (const auto &[u, trans_table] : dfa.GetDfaTable()) {
+      ids.emplace_back(u);
+    }
+    std::ranges::sort(ids);
+
+    auto index = std::unordered_map<StateId, size_t>{};
+    for (auto u : ids) {
+      auto &state = states_.emplace_back();
+      state.id = u;
+      state.accepting = dfa.GetF().contains(u);
+      state.next.fill(kDead);
+      for (const auto &[t, v] : dfa.GetDfaTable().at(u)) {
+        if (t.size() == 1) {
+          state.next[static_cast<uint8_t>(t[0])] = v;
+        }
+      }
+      index.emplace(u, index.size());
+    }
+
+    assert(index.contains(dfa.GetS()));
+    auto visits = std::vector<size_t>(states_.size());
+    auto Step = [&](StateId u, char c) {
+      ++visits[index.at(u)];
+      return states_[index.at(u)].next[static_cast<uint8_t>(c)];
+    };
+    auto u = dfa.GetS();
+    for (auto c : options_.sample) {
+      auto v = Step(u, c);
+      if (v == kDead && u != dfa.GetS()) {
+        v = Step(dfa.GetS(), c);
+      }
+      u = v == kDead ? dfa.GetS() : v;
+    }
+    visits[index.at(dfa.GetS())] = std::numeric_limits<size_t>::max();
+
+    auto order = std::vector<size_t>{};
+    for (size_t i = 0; i < states_.size(); ++i) {
+      order.emplace_back(i);
+    }
+    std::ranges::stable_sort(
+        order, [&visits](size_t a, size_t b) { return visits[a] > visits[b]; });
+
+    auto states = std::vector<State>{};
+    for (auto i : order) {
+      states.emplace_back(states_[i]);
+    }
+    states_ = std::move(states);
+  }
+
+  [[nodiscard]] std::vector<StateId> GetLayout() const {
+    auto res = std::vector<StateId>{};
+    for (const auto &state : states_) {
+      res.emplace_back(state.id);
+    }
+    return res;
+  }
+
+  [[nodiscard]] std::string Generate() const {
+    auto res = std::string{};
+    res += "// Generated by regex_fa_codegen, do not edit.\n";
+    res += "// " + std::to_string(states_.size()) + " states.\n";
+    res += "#pragma once\n\n";
+    res += "#include <cstddef>\n";
+    res += "#include <optional>\n";
+    res += "#include <string_view>\n\n";
+    if (!options_.nameSpace.empty()) {
+      res += "namespace " + options_.nameSpace + " {\n\n";
+    }
+    GenerateAccepts(res);
+    res += "\n";
+    GenerateLongestMatch(res);
+    if (!options_.nameSpace.empty()) {
+      res += "\n}  // namespace " + options_.nameSpace + "\n";
+    }
+    return res;
+  }
+
+ private:
+  [[nodiscard]] static std::string Label(StateId u) {
+    return "s" + std::to_string(u);
+  }
+
+  /**
+   * switch over input[i++], exits with on_dead for missing transitions.
+   */
+  static void GenerateSwitch(std::string &res, const State &state,
+                             std::string_view on_dead) {
+    auto targets = std::map<StateId, std::vector<unsigned>>{};
+    for (unsigned b = 0; b < 256; ++b) {
+      targets[state.next[b]].emplace_back(b);
+    }
+    auto largest = targets.begin();
+    for (auto it = targets.begin(); it != targets.end(); ++it) {
+      if (it->second.size() > largest->second.size()) {
+        largest = it;
+      }
+    }
+    auto Jump = [on_dead](StateId v) {
+      return v == kDead ? std::string{on_dead} : "goto " + Label(v) + ";";
+    };
+
+    res += "  switch (static_cast<unsigned char>(input[i++])) {\n";
+    for (auto it = targets.begin(); it != targets.end(); ++it) {
+      if (it == largest) {
+        continue;
+      }
+      auto line = std::string{"   "};
+      for (auto b : it->second) {
+        auto label = " case " + std::to_string(b) + ":";
+        if (line.size() + label.size() > 80) {
+          res += line + "\n";
+          line = "   ";
+        }
+        line += label;
+      }
+      res += line + "\n      " + Jump(it->first) + "\n";
+    }
+    res += "    default:\n      " + Jump(largest->first) + "\n";
+    res += "  }\n";
+  }
+
+  void GenerateAccepts(std::string &res) const {
+    res += "inline bool " + options_.name +
+           "Accepts(std::string_view input) {\n";
+    res += "  size_t i = 0;\n";
+    res += "  goto " + Label(states_.front().id) + ";\n";
+    for (const auto &state : states_) {
+      res += Label(state.id) + ":\n";
+      res += "  if (i == input.size()) {\n";
+      res += state.accepting ? "    return true;\n" : "    return false;\n";
+      res += "  }\n";
+      GenerateSwitch(res, state, "return false;");
+    }
+    res += "}\n";
+  }
+
+  void GenerateLongestMatch(std::string &res) const {
+    res += "inline std::optional<size_t> " + options_.name +
+           "LongestMatch(std::string_view input) {\n";
+    res += "  auto res = std::optional<size_t>{};\n";
+    res += "  size_t i = 0;\n";
+    res += "  goto " + Label(states_.front().id) + ";\n";
+    for (const auto &state : states_) {
+      res += Label(state.id) + ":\n";
+      if (state.accepting) {
+        res += "  res = i;\n";
+      }
+      res += "  if (i == input.size()) {\n    return res;\n  }\n";
+      GenerateSwitch(res, state, "return res;");
+    }
+    res += "}\n";
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_CODEGEN_HPP
@@ -0,0 +1,427 @@
+#ifndef REGEX_FA_DENSE_DFA_FILE_HPP
+#define REGEX_FA_DENSE_DFA_FILE_HPP
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define REGEX_FA_HAS_MMAP
+#endif
+
+#include "dense-dfa.hpp"
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Binary file of a DenseDfa, loadable without parsing.
+ *
+ * Layout, all integers in native byte order:
+ *   DenseDfaFileHeader
+ *   symbols        uint32 offsets[symbolCount + 1], then terminal bytes
+ *   symbolClasses  uint32 [symbolCount]
+ *   table          uint32 [stateCount * classCount], see DenseDfaView
+ *   accept         uint64 [(stateCount + 63) / 64]
+ *   byteClasses    uint32 [256]
+ *   stateIds       uint64 [stateCount], original Dfa StateIds
+ * Every section starts at a multiple of kDenseDfaFileAlignment, and the file
+ * is padded to one. checksum covers everything after the header.
+ */
+inline constexpr std::array<char, 8> kDenseDfaFileMagic = {
+    'R', 'E', 'G', 'E', 'X', 'F', 'A', '\0'};
+inline constexpr uint32_t kDenseDfaFileVersion = 2;
+inline constexpr uint32_t kDenseDfaFileByteOrder = 0x01020304;
+inline constexpr size_t kDenseDfaFileAlignment = 64;
+
+struct DenseDfaFileSection {
+  uint64_t offset{};
+  uint64_t size{};  // in bytes, without padding
+};
+
+struct DenseDfaFileHeader {
+  std::array<char, 8> magic{};
+  uint32_t version{};
+  uint32_t byteOrder{};
+  uint64_t fileSize{};
+  uint64_t checksum{};
+  uint32_t stateCount{};
+  uint32_t symbolCount{};
+  uint32_t classCount{};
+  uint32_t reserved{};
+  DenseDfaFileSection symbols{};
+  DenseDfaFileSection symbolClasses{};
+  DenseDfaFileSection table{};
+  DenseDfaFileSection accept{};
+  DenseDfaFileSection byteClasses{};
+  DenseDfaFileSection stateIds{};
+};
+
+static_assert(std::is_trivially_copyable_v<DenseDfaFileHeader>);
+
+class DenseDfaFileError : public std::runtime_error {
+ public:
+  explicit DenseDfaFileError(const std::string &message)
+      : std::runtime_error(message) {}
+};
+
+/**
+ * Checksum of a dense dfa file. Four independent lanes over 8-byte words, so
+ * verifying runs near memory speed. bytes.size() must be a multiple of 8.
+ */
+[[nodiscard]] inline uint64_t DenseDfaFileChecksum(
+    std::span<const std::byte> bytes) {
+  assert(bytes.size() % 8 == 0);
+  constexpr uint64_t kPrime = 0x9e3779b97f4a7c15;
+  auto lanes = std::array<uint64_t, 4>{1, 2, 3, 4};
+  const auto word_count = bytes.size() / 8;
+
+  auto Mix = [](uint64_t lane, uint64_t word) {
+    lane = (lane ^ word) * kPrime;
+    return lane ^ (lane >> 29);
+  };
+  auto Word = [&bytes](size_t i) {
+    auto word = uint64_t{};
+    std::memcpy(&word, bytes.data() + i * 8, 8);
+    return word;
+  };
+
+  size_t i = 0;
+  for (; i + 4 <= word_count; i += 4) {
+    for (size_t lane = 0; lane < 4; ++lane) {
+      lanes[lane] = Mix(lanes[lane], Word(i + lane));
+    }
+  }
+  for (; i < word_count; ++i) {
+    lanes[0] = Mix(lanes[0], Word(i));
+  }
+
+  auto res = uint64_t{bytes.size()};
+  for (auto lane : lanes) {
+    res = Mix(res, lane);
+  }
+  return res;
+}
+
+/**
+ * Write dfa in the dense dfa file format.
+ */
+[[nodiscard]] inline std::vector<std::byte> SerializeDenseDfa(
+    const DenseDfa &dfa) {
+  constexpr auto kAlignment = kDenseDfaFileAlignment;
+  auto AlignUp = [](size_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  };
+
+  const auto view = dfa.View();
+  const auto &terminals = dfa.GetSymbolTable().GetTerminals();
+  auto symbol_offsets = std::vector<uint32_t>{0};
+  for (const auto &terminal : terminals) {
+    symbol_offsets.emplace_back(symbol_offsets.back() +
+                                static_cast<uint32_t>(terminal.size()));
+  }
+  auto state_ids = std::vector<uint64_t>{};
+  for (DenseDfa::DenseStateId u = 0; u < dfa.StateCount(); ++u) {
+    state_ids.emplace_back(dfa.GetStateId(u));
+  }
+
+  auto header = DenseDfaFileHeader{};
+  header.magic = kDenseDfaFileMagic;
+  header.version = kDenseDfaFileVersion;
+  header.byteOrder = kDenseDfaFileByteOrder;
+  header.stateCount = static_cast<uint32_t>(dfa.StateCount());
+  header.symbolCount = static_cast<uint32_t>(dfa.SymbolCount());
+  header.classCount = static_cast<uint32_t>(dfa.ClassCount());
+
+  auto size = AlignUp(sizeof(DenseDfaFileHeader));
+  auto Place = [&](DenseDfaFileSection &section, size_t section_size) {
+    section = {size, section_size};
+    size = AlignUp(size + section_size);
+  };
+  Place(header.symbols,
+        symbol_offsets.size() * sizeof(uint32_t) + symbol_offsets.back());
+  Place(header.symbolClasses, view.GetSymbolClasses().size_bytes());
+  Place(header.table, view.GetTable().size_bytes());
+  Place(header.accept, view.GetAccept().size_bytes());
+  Place(header.byteClasses, view.GetByteClasses().size_bytes());
+  Place(header.stateIds, state_ids.size() * sizeof(uint64_t));
+  header.fileSize = size;
+
+  auto res = std::vector<std::byte>(size);
+  auto Write = [&res](size_t offset, const void *data, size_t data_size) {
+    if (data_size != 0) {
+      std::memcpy(res.data() + offset, data, data_size);
+    }
+  };
+  Write(header.symbols.offset, symbol_offsets.data(),
+        symbol_offsets.size() * sizeof(uint32_t));
+  auto terminal_offset =
+      header.symbols.offset + symbol_offsets.size() * sizeof(uint32_t);
+  for (const auto &terminal : terminals) {
+    Write(terminal_offset, terminal.data(), terminal.size());
+    terminal_offset += terminal.size();
+  }
+  Write(header.symbolClasses.offset, view.GetSymbolClasses().data(),
+        header.symbolClasses.size);
+  Write(header.table.offset, view.GetTable().data(), header.table.size);
+  Write(header.accept.offset, view.GetAccept().data(), header.accept.size);
+  Write(header.byteClasses.offset, view.GetByteClasses().data(),
+        header.byteClasses.size);
+  Write(header.stateIds.offset, state_ids.data(), header.stateIds.size);
+
+  header.checksum = DenseDfaFileChecksum(
+      std::span{res}.subspan(AlignUp(sizeof(DenseDfaFileHeader))));
+  Write(0, &header, sizeof(header));
+  return res;
+}
+
+inline void SaveDenseDfa(const DenseDfa &dfa, const std::string &path) {
+  const auto bytes = SerializeDenseDfa(dfa);
+  auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+  out.write(reinterpret_cast<const char *>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+  if (!out) {
+    throw DenseDfaFileError("cannot write " + path);
+  }
+}
+
+/**
+ * Dense dfa file checked and split into sections, pointing into bytes that
+ * are owned elsewhere and must outlive it.
+ */
+class DenseDfaImage {
+ private:
+  DenseDfaView view_;
+  std::span<const uint32_t> symbol_offsets_;
+  const char *symbol_bytes_{nullptr};
+  std::span<const uint64_t> state_ids_;
+
+ public:
+  DenseDfaImage() = default;
+
+  /**
+   * Check the header and the section bounds, and with verify also the
+   * checksum and every transition. Without verify only the header and the
+   * small sections are read.
+   * bytes must be 8-byte aligned.
+   * The checksum catches corrupted files, not crafted ones.
+   * @throw DenseDfaFileError if bytes is not a valid file.
+   */
+  DenseDfaImage(std::span<const std::byte> bytes, bool verify) {
+    auto header = DenseDfaFileHeader{};
+    if (bytes.size() < sizeof(header)) {
+      throw DenseDfaFileError("truncated header");
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != kDenseDfaFileMagic) {
+      throw DenseDfaFileError("not a dense dfa file");
+    }
+    if (header.byteOrder != kDenseDfaFileByteOrder) {
+      throw DenseDfaFileError("byte order mismatch");
+    }
+    if (header.version != kDenseDfaFileVersion) {
+      throw DenseDfaFileError("unsupported version " +
+                              std::to_string(header.version));
+    }
+    if (header.fileSize != bytes.size()) {
+      throw DenseDfaFileError("file size mismatch");
+    }
+    if (header.stateCount == 0 || header.classCount == 0) {
+      throw DenseDfaFileError("no states or classes");
+    }
+
+    const uint64_t state_count = header.stateCount;
+    const uint64_t symbol_count = header.symbolCount;
+    const uint64_t class_count = header.classCount;
+    auto Section = [&bytes](const DenseDfaFileSection &section,
+                            uint64_t expected_size, const char *name) {
+      if (section.offset % kDenseDfaFileAlignment != 0 ||
+          section.offset > bytes.size() ||
+          section.size > bytes.size() - section.offset ||
+          section.size != expected_size) {
+        throw DenseDfaFileError(std::string("bad section ") + name);
+      }
+      return bytes.data() + section.offset;
+    };
+
+    const auto *symbols =
+        Section(header.symbols, header.symbols.size, "symbols");
+    const auto offsets_size = (symbol_count + 1) * sizeof(uint32_t);
+    if (header.symbols.size < offsets_size) {
+      throw DenseDfaFileError("bad section symbols");
+    }
+    symbol_offsets_ = {reinterpret_cast<const uint32_t *>(symbols),
+                       symbol_count + 1};
+    symbol_bytes_ = reinterpret_cast<const char *>(symbols + offsets_size);
+    if (symbol_offsets_.front() != 0 ||
+        !std::ranges::is_sorted(symbol_offsets_) ||
+        symbol_offsets_.back() != header.symbols.size - offsets_size) {
+      throw DenseDfaFileError("bad symbol offsets");
+    }
+
+    const auto *symbol_classes =
+        Section(header.symbolClasses, symbol_count * 4, "symbolClasses");
+    const auto *table =
+        Section(header.table, state_count * class_count * 4, "table");
+    const auto *accept =
+        Section(header.accept, (state_count + 63) / 64 * 8, "accept");
+    const auto *byte_classes =
+        Section(header.byteClasses, 256 * 4, "byteClasses");
+    const auto *state_ids =
+        Section(header.stateIds, state_count * 8, "stateIds");
+
+    view_ = DenseDfaView{
+        state_count,
+        class_count,
+        {reinterpret_cast<const DenseDfaView::DenseStateId *>(table),
+         state_count * class_count},
+        {reinterpret_cast<const uint64_t *>(accept), (state_count + 63) / 64},
+        {reinterpret_cast<const ClassId *>(symbol_classes), symbol_count},
+        std::span<const ClassId, 256>{
+            reinterpret_cast<const ClassId *>(byte_classes), 256}};
+    state_ids_ = {reinterpret_cast<const uint64_t *>(state_ids), state_count};
+
+    auto IsClass = [class_count](ClassId c) { return c < class_count; };
+    if (!std::ranges::all_of(view_.GetSymbolClasses(), IsClass) ||
+        !std::ranges::all_of(view_.GetByteClasses(), IsClass)) {
+      throw DenseDfaFileError("bad class");
+    }
+
+    if (verify) {
+      const auto payload_offset =
+          (sizeof(header) + kDenseDfaFileAlignment - 1) /
+          kDenseDfaFileAlignment * kDenseDfaFileAlignment;
+      if (bytes.size() < payload_offset || bytes.size() % 8 != 0 ||
+          DenseDfaFileChecksum(bytes.subspan(payload_offset)) !=
+              header.checksum) {
+        throw DenseDfaFileError("checksum mismatch");
+      }
+      for (auto v : view_.GetTable()) {
+        if (v != DenseDfaView::kDeadState && v >= state_count) {
+          throw DenseDfaFileError("bad transition");
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] const DenseDfaView &View() const { return view_; }
+  [[nodiscard]] size_t StateCount() const { return view_.StateCount(); }
+  [[nodiscard]] size_t SymbolCount() const { return view_.SymbolCount(); }
+
+  [[nodiscard]] std::string_view GetTerminal(SymbolId t) const {
+    assert(t < SymbolCount());
+    return {symbol_bytes_ + symbol_offsets_[t],
+            symbol_offsets_[t + 1] - symbol_offsets_[t]};
+  }
+
+  /**
+   * Original Dfa StateId of a dense state.
+   */
+  [[nodiscard]] StateId GetStateId(DenseDfaView::DenseStateId u) const {
+    assert(u < StateCount());
+    return static_cast<StateId>(state_ids_[u]);
+  }
+};
+
+/**
+ * Dense dfa file mapped read only into memory. Opening reads only the header
+ * and the small sections unless verify is set, the transition matrix is paged
+ * in as matching touches it. Without mmap the file is read into memory.
+ */
+class MappedDfa {
+ private:
+  const std::byte *data_{nullptr};
+  size_t size_{0};
+  std::vector<uint64_t> buffer_;  // file contents, if not mapped
+  DenseDfaImage image_;
+
+ public:
+  /**
+   * @param verify Check the checksum and every transition, which reads the
+   * whole file.
+   * @throw DenseDfaFileError if the file cannot be read or is not valid.
+   */
+  explicit MappedDfa(const std::string &path, bool verify = true) {
+#ifdef REGEX_FA_HAS_MMAP
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw DenseDfaFileError("cannot open " + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      throw DenseDfaFileError("cannot map " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    auto *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      throw DenseDfaFileError("cannot map " + path);
+    }
+    data_ = static_cast<const std::byte *>(data);
+#else
+    auto in = std::ifstream{path, std::ios::binary | std::ios::ate};
+    if (!in) {
+      throw DenseDfaFileError("cannot open " + path);
+    }
+    size_ = static_cast<size_t>(in.tellg());
+    buffer_.resize((size_ + 7) / 8);
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(buffer_.data()),
+            static_cast<std::streamsize>(size_));
+    if (!in) {
+      throw DenseDfaFileError("cannot read " + path);
+    }
+    data_ = reinterpret_cast<const std::byte *>(buffer_.data());
+#endif
+    try {
+      image_ = DenseDfaImage{{data_, size_}, verify};
+    } catch (...) {
+      Unmap();
+      throw;
+    }
+  }
+
+  MappedDfa(MappedDfa &&other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        buffer_(std::move(other.buffer_)),
+        image_(other.image_) {}
+
+  MappedDfa &operator=(MappedDfa &&other) noexcept {
+    if (this != &other) {
+      Unmap();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      buffer_ = std::move(other.buffer_);
+      image_ = other.image_;
+    }
+    return *this;
+  }
+
+  MappedDfa(const MappedDfa &) = delete;
+  MappedDfa &operator=(const MappedDfa &) = delete;
+
+  ~MappedDfa() { Unmap(); }
+
+  [[nodiscard]] const DenseDfaImage &GetImage() const { return image_; }
+  [[nodiscard]] const DenseDfaView &View() const { return image_.View(); }
+
+ private:
+  void Unmap() {
+#ifdef REGEX_FA_HAS_MMAP
+    if (data_ != nullptr) {
+      ::munmap(const_cast<std::byte *>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_DENSE_DFA_FILE_HPP
@@ -0,0 +1,212 @@
+#ifndef REGEX_FA_DENSE_DFA_VIEW_HPP
+#define REGEX_FA_DENSE_DFA_VIEW_HPP
+
+#include "alphabet.hpp"
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Match of input[begin, end).
+ */
+struct Match {
+  size_t begin{};
+  size_t end{};
+
+  bool operator==(const Match &) const = default;
+};
+
+/**
+ * Matcher over the flat arrays of a DenseDfa, owned elsewhere, either by a
+ * DenseDfa or by a mapped file.
+ * States are numbered 0..n-1 with the start state first. Symbols are grouped
+ * into alphabet equivalence classes, see SymbolClasses, and transitions form
+ * a row-major n * classes matrix. Missing transitions go to kDeadState.
+ * Matching works on bytes: each single-byte Terminal matches that byte, other
+ * terminals never match. Every byte has a class, bytes without a terminal
+ * share one that only leads to kDeadState, so matching needs no branch per
+ * byte. Matching does not allocate.
+ */
+class DenseDfaView {
+ public:
+  using DenseStateId = uint32_t;
+
+  static constexpr DenseStateId kDeadState =
+      std::numeric_limits<DenseStateId>::max();
+
+ private:
+  size_t state_count_{0};
+  size_t symbol_count_{0};
+  size_t class_count_{0};
+  const DenseStateId *table_{nullptr};  // table_[u * class_count_ + c] = v
+  const uint64_t *accept_{nullptr};     // bitmap over states
+  const ClassId *symbol_classes_{nullptr};  // symbol -> class
+  const ClassId *byte_classes_{nullptr};    // byte -> class
+
+ public:
+  DenseDfaView() = default;
+
+  /**
+   * @param table state_count * class_count transitions.
+   * @param accept Bitmap of (state_count + 63) / 64 words.
+   * @param symbol_classes Class of each symbol, symbol_count entries.
+   */
+  DenseDfaView(size_t state_count, size_t class_count,
+               std::span<const DenseStateId> table,
+               std::span<const uint64_t> accept,
+               std::span<const ClassId> symbol_classes,
+               std::span<const ClassId, 256> byte_classes)
+      : state_count_(state_count),
+        symbol_count_(symbol_classes.size()),
+        class_count_(class_count),
+        table_(table.data()),
+        accept_(accept.data()),
+        symbol_classes_(symbol_classes.data()),
+        byte_classes_(byte_classes.data()) {
+    assert(table.size() == state_count * class_count);
+    assert(accept.size() == (state_count + 63) / 64);
+  }
+
+  [[nodiscard]] size_t StateCount() const { return state_count_; }
+  [[nodiscard]] size_t SymbolCount() const { return symbol_count_; }
+  [[nodiscard]] size_t ClassCount() const { return class_count_; }
+
+  /**
+   * Start state is always 0.
+   */
+  [[nodiscard]] static constexpr DenseStateId GetS() { return 0; }
+
+  [[nodiscard]] ClassId GetClass(SymbolId t) const {
+    assert(t < SymbolCount());
+    return symbol_classes_[t];
+  }
+
+  [[nodiscard]] ClassId GetClass(std::byte byte) const {
+    return byte_classes_[std::to_integer<uint8_t>(byte)];
+  }
+
+  [[nodiscard]] DenseStateId Next(DenseStateId u, SymbolId t) const {
+    return NextByClass(u, GetClass(t));
+  }
+
+  /**
+   * Run from state u over one byte.
+   */
+  [[nodiscard]] DenseStateId Next(DenseStateId u, std::byte byte) const {
+    return NextByClass(u, GetClass(byte));
+  }
+
+  [[nodiscard]] DenseStateId NextByClass(DenseStateId u, ClassId c) const {
+    assert(u < StateCount() && c < ClassCount());
+    return table_[u * class_count_ + c];
+  }
+
+  [[nodiscard]] bool IsAccepting(DenseStateId u) const {
+    assert(u < StateCount());
+    return (accept_[u / 64] >> (u % 64)) & 1;
+  }
+
+  [[nodiscard]] std::span<const DenseStateId> GetTable() const {
+    return {table_, state_count_ * class_count_};
+  }
+
+  [[nodiscard]] std::span<const uint64_t> GetAccept() const {
+    return {accept_, (state_count_ + 63) / 64};
+  }
+
+  [[nodiscard]] std::span<const ClassId> GetSymbolClasses() const {
+    return {symbol_classes_, symbol_count_};
+  }
+
+  [[nodiscard]] std::span<const ClassId, 256> GetByteClasses() const {
+    return std::span<const ClassId, 256>{byte_classes_, 256};
+  }
+
+  /**
+   * Full match, whether the whole input is accepted.
+   */
+  [[nodiscard]] bool Accepts(std::span<const std::byte> input) const {
+    auto u = GetS();
+    for (auto byte : input) {
+      u = Next(u, byte);
+      if (u == kDeadState) {
+        return false;
+      }
+    }
+    return IsAccepting(u);
+  }
+
+  [[nodiscard]] bool Accepts(std::string_view input) const {
+    return Accepts(AsBytes(input));
+  }
+
+  /**
+   * Longest accepted prefix of input.
+   * @return Length of the prefix, or nullopt if no prefix (not even the empty
+   * one) is accepted.
+   */
+  [[nodiscard]] std::optional<size_t> LongestMatch(
+      std::span<const std::byte> input) const {
+    auto res = std::optional<size_t>{};
+    auto u = GetS();
+    if (IsAccepting(u)) {
+      res = 0;
+    }
+    for (size_t i = 0; i < input.size(); ++i) {
+      u = Next(u, input[i]);
+      if (u == kDeadState) {
+        break;
+      }
+      if (IsAccepting(u)) {
+        res = i + 1;
+      }
+    }
+    return res;
+  }
+
+  [[nodiscard]] std::optional<size_t> LongestMatch(
+      std::string_view input) const {
+    return LongestMatch(AsBytes(input));
+  }
+
+  /**
+   * Find all leftmost-longest, non-overlapping, non-empty matches.
+   * @param on_match Called as on_match(Match) for each match, in order.
+   */
+  template <typename OnMatch>
+  void FindAll(std::span<const std::byte> input, OnMatch &&on_match) const {
+    size_t begin = 0;
+    while (begin < input.size()) {
+      auto len = LongestMatch(input.subspan(begin));
+      if (len.has_value() && len.value() > 0) {
+        on_match(Match{begin, begin + len.value()});
+        begin += len.value();
+      } else {
+        ++begin;
+      }
+    }
+  }
+
+  template <typename OnMatch>
+  void FindAll(std::string_view input, OnMatch &&on_match) const {
+    FindAll(AsBytes(input), std::forward<OnMatch>(on_match));
+  }
+
+  /**
+   * Same as FindAll(input, on_match), collecting matches into a vector.
+   */
+  [[nodiscard]] std::vector<Match> FindAll(std::string_view input) const {
+    auto res = std::vector<Match>{};
+    FindAll(input, [&res](const Match &match) { res.emplace_back(match); });
+    return res;
+  }
+
+  [[nodiscard]] static std::span<const std::byte> AsBytes(
+      std::string_view input) {
+    return std::as_bytes(std::span{input.data(), input.size()});
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_DENSE_DFA_VIEW_HPP
@@ -0,0 +1,260 @@
+#ifndef REGEX_FA_DENSE_DFA_HPP
+#define REGEX_FA_DENSE_DFA_HPP
+
+#include "alphabet.hpp"
+#include "dense-dfa-view.hpp"
+#include "dfa.hpp"
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Dfa compiled into flat arrays for matching.
+ * States are numbered 0..n-1 with the start state first, terminals are
+ * interned into a SymbolTable and grouped into alphabet equivalence classes,
+ * and transitions form a row-major n * classes matrix. Missing transitions go
+ * to kDeadState.
+ * Matching is done by DenseDfaView, see View().
+ */
+class DenseDfa {
+ public:
+  using DenseStateId = DenseDfaView::DenseStateId;
+
+  static constexpr DenseStateId kDeadState = DenseDfaView::kDeadState;
+
+ private:
+  SymbolTable symbols_;
+  size_t class_count_{0};
+  std::vector<DenseStateId> table_;  // table_[u * class_count_ + c] = v
+  std::vector<uint64_t> accept_;     // bitmap over dense states
+  std::vector<StateId> state_ids_;   // dense state -> original state
+  std::vector<uint32_t> pattern_first_;  // dense state -> range in patterns_
+  std::vector<PatternId> patterns_;
+  std::vector<ClassId> symbol_classes_;       // symbol -> class
+  std::array<ClassId, 256> byte_classes_{};  // byte -> class
+
+ public:
+  explicit DenseDfa(const Dfa &dfa) {
+    auto states = States{};
+    auto terminals = Terminals{};
+    for (const auto &[u, trans_table] : dfa.GetDfaTable()) {
+      states.emplace(u);
+      for (const auto &[t, v] : trans_table) {
+        terminals.emplace(t);
+        states.emplace(v);
+      }
+    }
+
+    Build(
+        states, terminals, dfa.GetS(), dfa.GetF(),
+        [&dfa](auto &&AddEdge) {
+          for (const auto &[u, trans_table] : dfa.GetDfaTable()) {
+            for (const auto &[t, v] : trans_table) {
+              AddEdge(u, t, v);
+            }
+          }
+        },
+        [&dfa](StateId u) { return dfa.GetPatterns(u); });
+  }
+
+  explicit DenseDfa(const FlatDfa &flat_dfa) {
+    auto states = States{flat_dfa.states.begin(), flat_dfa.states.end()};
+    auto terminals = Terminals{};
+    for (const auto &[u, v, t] : flat_dfa.flatEdges) {
+      states.emplace(u);
+      states.emplace(v);
+      terminals.emplace(t);
+    }
+    auto f = States{flat_dfa.f.begin(), flat_dfa.f.end()};
+
+    Build(
+        states, terminals, flat_dfa.s, f,
+        [&flat_dfa](auto &&AddEdge) {
+          for (const auto &[u, v, t] : flat_dfa.flatEdges) {
+            AddEdge(u, t, v);
+          }
+        },
+        [&f](StateId u) {
+          return f.contains(u) ? std::span<const PatternId>{kDefaultPatterns}
+                               : std::span<const PatternId>{};
+        });
+  }
+
+  [[nodiscard]] const SymbolTable &GetSymbolTable() const { return symbols_; }
+  [[nodiscard]] size_t StateCount() const { return state_ids_.size(); }
+  [[nodiscard]] size_t SymbolCount() const { return symbols_.Size(); }
+  [[nodiscard]] size_t ClassCount() const { return class_count_; }
+
+  /**
+   * Start state is always 0.
+   */
+  [[nodiscard]] static constexpr DenseStateId GetS() { return 0; }
+
+  [[nodiscard]] DenseDfaView View() const {
+    return {StateCount(), ClassCount(), table_, accept_, symbol_classes_,
+            byte_classes_};
+  }
+
+  /**
+   * Original Dfa StateId of a dense state.
+   */
+  [[nodiscard]] StateId GetStateId(DenseStateId u) const {
+    assert(u < StateCount());
+    return state_ids_[u];
+  }
+
+  [[nodiscard]] DenseStateId Next(DenseStateId u, SymbolId t) const {
+    return View().Next(u, t);
+  }
+
+  [[nodiscard]] DenseStateId Next(DenseStateId u, std::byte byte) const {
+    return View().Next(u, byte);
+  }
+
+  [[nodiscard]] bool IsAccepting(DenseStateId u) const {
+    return View().IsAccepting(u);
+  }
+
+  /**
+   * Patterns accepted by u, sorted, empty if it is not accepting.
+   */
+  [[nodiscard]] std::span<const PatternId> GetPatterns(DenseStateId u) const {
+    assert(u < StateCount());
+    return {patterns_.data() + pattern_first_[u],
+            patterns_.data() + pattern_first_[u + 1]};
+  }
+
+  [[nodiscard]] std::span<const DenseStateId> GetTable() const {
+    return table_;
+  }
+
+  [[nodiscard]] bool Accepts(std::span<const std::byte> input) const {
+    return View().Accepts(input);
+  }
+
+  [[nodiscard]] bool Accepts(std::string_view input) const {
+    return View().Accepts(input);
+  }
+
+  [[nodiscard]] std::optional<size_t> LongestMatch(
+      std::span<const std::byte> input) const {
+    return View().LongestMatch(input);
+  }
+
+  [[nodiscard]] std::optional<size_t> LongestMatch(
+      std::string_view input) const {
+    return View().LongestMatch(input);
+  }
+
+  template <typename Input, typename OnMatch>
+  void FindAll(Input &&input, OnMatch &&on_match) const {
+    View().FindAll(std::forward<Input>(input),
+                   std::forward<OnMatch>(on_match));
+  }
+
+  [[nodiscard]] std::vector<Match> FindAll(std::string_view input) const {
+    return View().FindAll(input);
+  }
+
+  [[nodiscard]] FlatDfa ToFlatDfa() const {
+    auto flat_dfa = FlatDfa{};
+    flat_dfa.s = GetS();
+    for (DenseStateId u = 0; u < StateCount(); ++u) {
+      flat_dfa.states.emplace_back(u);
+      if (IsAccepting(u)) {
+        flat_dfa.f.emplace_back(u);
+      }
+      for (SymbolId t = 0; t < SymbolCount(); ++t) {
+        if (auto v = Next(u, t); v != kDeadState) {
+          flat_dfa.flatEdges.emplace_back(u, v, symbols_.GetTerminal(t));
+        }
+      }
+    }
+    return flat_dfa;
+  }
+
+ private:
+  /**
+   * @param for_each_edge Calls its argument as AddEdge(u, t, v) for every
+   * transition u --t-> v.
+   * @param patterns_of patterns_of(u) are the patterns accepted by u.
+   */
+  template <typename ForEachEdge, typename PatternsOf>
+  void Build(const States &states, const Terminals &terminals, StateId s,
+             const States &f, ForEachEdge &&for_each_edge,
+             PatternsOf &&patterns_of) {
+    symbols_ = SymbolTable{terminals};
+
+    // Start state first, then the others in ascending order.
+    state_ids_.emplace_back(s);
+    for (auto state_id : toFlatStates(states)) {
+      if (state_id != s) {
+        state_ids_.emplace_back(state_id);
+      }
+    }
+    assert(state_ids_.size() < kDeadState);
+
+    auto dense_ids = std::unordered_map<StateId, DenseStateId>{};
+    for (DenseStateId u = 0; u < state_ids_.size(); ++u) {
+      dense_ids.emplace(state_ids_[u], u);
+    }
+
+    // One column per symbol first.
+    const auto symbol_count = SymbolCount();
+    auto table = std::vector<DenseStateId>(StateCount() * symbol_count,
+                                           kDeadState);
+    for_each_edge([&](StateId u, const Terminal &t, StateId v) {
+      table[dense_ids.at(u) * symbol_count + symbols_.Find(t)] =
+          dense_ids.at(v);
+    });
+
+    // Merge identical columns. Symbol symbol_count stands for the bytes
+    // without a terminal, it goes nowhere.
+    auto classes = SymbolClasses{symbol_count + 1};
+    auto edges = std::vector<SymbolClasses::Edge>{};
+    for (size_t u = 0; u < StateCount(); ++u) {
+      edges.clear();
+      for (SymbolId t = 0; t < symbol_count; ++t) {
+        edges.emplace_back(table[u * symbol_count + t], t);
+      }
+      edges.emplace_back(kDeadState, static_cast<SymbolId>(symbol_count));
+      classes.Refine(edges);
+    }
+    const auto class_of = classes.GetClasses();
+    class_count_ = classes.Size();
+    symbol_classes_.assign(class_of.begin(), class_of.end() - 1);
+
+    table_.assign(StateCount() * ClassCount(), kDeadState);
+    for (size_t u = 0; u < StateCount(); ++u) {
+      for (SymbolId t = 0; t < symbol_count; ++t) {
+        table_[u * ClassCount() + class_of[t]] = table[u * symbol_count + t];
+      }
+    }
+
+    byte_classes_.fill(class_of.back());
+    for (SymbolId t = 0; t < symbol_count; ++t) {
+      if (const auto &terminal = symbols_.GetTerminal(t);
+          terminal.size() == 1) {
+        byte_classes_[static_cast<uint8_t>(terminal[0])] = class_of[t];
+      }
+    }
+
+    accept_.assign((StateCount() + 63) / 64, 0);
+    for (auto state_id : f) {
+      if (auto it = dense_ids.find(state_id); it != dense_ids.end()) {
+        accept_[it->second / 64] |= uint64_t{1} << (it->second % 64);
+      }
+    }
+
+    pattern_first_.emplace_back(0);
+    for (auto state_id : state_ids_) {
+      const auto patterns = patterns_of(state_id);
+      patterns_.insert(patterns_.end(), patterns.begin(), patterns.end());
+      pattern_first_.emplace_back(static_cast<uint32_t>(patterns_.size()));
+    }
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_DENSE_DFA_HPP
@@ -0,0 +1,130 @@
+#ifndef REGEX_FA_DENSE_NFA_HPP
+#define REGEX_FA_DENSE_NFA_HPP
+
+#include "alphabet.hpp"
+#include "epsilon-closure.hpp"
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Nfa over contiguous states and interned terminals, built by
+ * Nfa::ToDenseNfa() for subset construction.
+ * Dense state i is states[i], states are ascending.
+ * Epsilon edges are not in edges, only in closure.
+ */
+struct DenseNfa {
+  struct Edge {
+    SymbolId symbol{};
+    uint32_t target{};
+
+    auto operator<=>(const Edge &) const = default;
+  };
+
+  /**
+   * Scratch of ForEachNext, one per thread.
+   */
+  struct NextScratch {
+    std::pmr::vector<std::pmr::vector<uint32_t>> targets{};  // symbol -> targets
+    std::pmr::vector<SymbolId> usedSymbols{};
+    std::pmr::vector<uint32_t> stamp{};
+    uint32_t curStamp{0};
+    std::pmr::vector<uint32_t> next{};
+
+    NextScratch() = default;
+
+    explicit NextScratch(std::pmr::memory_resource *resource)
+        : targets(resource),
+          usedSymbols(resource),
+          stamp(resource),
+          next(resource) {}
+  };
+
+  FlatStates states{};
+  SymbolTable symbols{};
+  std::vector<uint32_t> edgeFirst{};  // u -> range in edges
+  std::vector<Edge> edges{};          // sorted by symbol for each u
+  EpsilonClosure closure{};
+  std::vector<uint8_t> isFinal{};
+  std::vector<PatternIds> patterns{};  // u -> patterns, empty if not final
+  uint32_t s{};
+
+  [[nodiscard]] size_t Size() const { return states.size(); }
+
+  [[nodiscard]] std::span<const Edge> GetEdges(uint32_t u) const {
+    return {edges.data() + edgeFirst[u], edges.data() + edgeFirst[u + 1]};
+  }
+
+  [[nodiscard]] bool HasFinal(std::span<const uint32_t> subset) const {
+    return std::ranges::any_of(subset, [this](auto u) { return isFinal[u]; });
+  }
+
+  /**
+   * Sorted union of the patterns of the final states in subset.
+   */
+  [[nodiscard]] PatternIds GetPatterns(std::span<const uint32_t> subset) const {
+    auto res = PatternIds{};
+    for (auto u : subset) {
+      res.insert(res.end(), patterns[u].begin(), patterns[u].end());
+    }
+    std::ranges::sort(res);
+    res.erase(std::ranges::unique(res).begin(), res.end());
+    return res;
+  }
+
+  /**
+   * Every subset reachable from subset by one terminal, with epsilon closure.
+   * @param on_next Called as on_next(t, next_subset) in ascending order of t,
+   * next_subset is sorted and only valid during the call.
+   */
+  template <typename OnNext>
+  void ForEachNext(std::span<const uint32_t> subset, NextScratch &scratch,
+                   OnNext &&on_next) const {
+    scratch.targets.resize(symbols.Size());
+    scratch.stamp.resize(Size(), 0);
+
+    for (auto u : subset) {
+      for (const auto &[t, v] : GetEdges(u)) {
+        if (scratch.targets[t].empty()) {
+          scratch.usedSymbols.emplace_back(t);
+        }
+        scratch.targets[t].emplace_back(v);
+      }
+    }
+    std::ranges::sort(scratch.usedSymbols);
+
+    for (auto t : scratch.usedSymbols) {
+      // Union of the closures of all targets.
+      ++scratch.curStamp;
+      scratch.next.clear();
+      for (auto v : scratch.targets[t]) {
+        for (auto w : closure.Get(v)) {
+          if (scratch.stamp[w] != scratch.curStamp) {
+            scratch.stamp[w] = scratch.curStamp;
+            scratch.next.emplace_back(w);
+          }
+        }
+      }
+      scratch.targets[t].clear();
+      std::ranges::sort(scratch.next);
+      on_next(t, std::span<const uint32_t>{scratch.next});
+    }
+    scratch.usedSymbols.clear();
+  }
+
+  /**
+   * Subset of dense states back to Nfa states.
+   */
+  [[nodiscard]] FlatStates ToFlatStates(
+      std::span<const uint32_t> subset) const {
+    auto res = FlatStates{};
+    for (auto u : subset) {
+      res.emplace_back(states[u]);
+    }
+    return res;
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_DENSE_NFA_HPP
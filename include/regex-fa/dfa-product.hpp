@@ -0,0 +1,258 @@
+#ifndef REGEX_FA_DFA_PRODUCT_HPP
+#define REGEX_FA_DFA_PRODUCT_HPP
+
+#include "alphabet.hpp"
+#include "dfa.hpp"
+#include "fa-include.hpp"
+#include "subset-table.hpp"
+
+namespace regex_fa {
+
+/**
+ * Language of a pair of states of the product of Dfas a and b.
+ */
+enum class ProductOp : uint8_t {
+  kIntersection,         // a and b
+  kUnion,                // a or b
+  kDifference,           // a and not b
+  kSymmetricDifference,  // a xor b
+};
+
+/**
+ * Product construction of two Dfas over their shared interned alphabet.
+ * Both Dfas are made complete with a dead state, pairs are interned into a
+ * SubsetTable and only pairs reachable from (s, s) are explored. Pairs that
+ * cannot be accepted under the op, e.g. (dead, v) for kIntersection, are
+ * not explored either.
+ * Patterns are not kept, a final state of a result accepts pattern 0.
+ */
+class DfaProduct {
+ private:
+  /**
+   * Complete Dfa over symbols_, states 0..n-1 and the dead state n.
+   */
+  struct DenseSide {
+    std::vector<uint32_t> table{};  // table[u * symbol_count + t]
+    std::vector<bool> f{};
+    uint32_t s{};
+    uint32_t dead{};
+  };
+
+  SymbolTable symbols_;
+  DenseSide a_;
+  DenseSide b_;
+
+ public:
+  DfaProduct(const Dfa &a, const Dfa &b) {
+    auto terminals = GetTerminals(a);
+    terminals.merge(GetTerminals(b));
+    symbols_ = SymbolTable{terminals};
+    a_ = ToDenseSide(a, symbols_);
+    b_ = ToDenseSide(b, symbols_);
+  }
+
+  [[nodiscard]] const SymbolTable &GetSymbolTable() const { return symbols_; }
+
+  /**
+   * Minimal Dfa of op over the reachable pairs.
+   */
+  [[nodiscard]] Dfa Build(ProductOp op) const {
+    auto dfa_table = Dfa::DfaTable{{0, {}}};
+    auto f = States{};
+    Explore(
+        op,
+        [&](uint32_t u, SymbolId t, uint32_t v) {
+          dfa_table[u][symbols_.GetTerminal(t)] = v;
+          return false;
+        },
+        [&f](uint32_t u) {
+          f.emplace(u);
+          return false;
+        });
+    return Dfa{std::move(dfa_table), 0, std::move(f)}.Minimize();
+  }
+
+  /**
+   * Shortest word in the language of op, found by breadth first search that
+   * stops at the first accepting pair.
+   * @return The word, or nullopt if the language is empty.
+   */
+  [[nodiscard]] std::optional<std::vector<Terminal>> FindWord(
+      ProductOp op) const {
+    auto parents = std::vector<std::pair<uint32_t, SymbolId>>{{0, 0}};
+    auto found = std::optional<uint32_t>{};
+    Explore(
+        op,
+        [&parents](uint32_t u, SymbolId t, uint32_t v) {
+          if (v == parents.size()) {
+            parents.emplace_back(u, t);
+          }
+          return false;
+        },
+        [&found](uint32_t u) {
+          found = u;
+          return true;
+        });
+    if (!found.has_value()) {
+      return std::nullopt;
+    }
+    auto res = std::vector<Terminal>{};
+    for (auto u = found.value(); u != 0; u = parents[u].first) {
+      res.emplace_back(symbols_.GetTerminal(parents[u].second));
+    }
+    std::ranges::reverse(res);
+    return res;
+  }
+
+  [[nodiscard]] bool IsEmpty(ProductOp op) const {
+    return !FindWord(op).has_value();
+  }
+
+  [[nodiscard]] static Terminals GetTerminals(const Dfa &dfa) {
+    const auto &terminals = dfa.GetIndex().terminals;
+    return {terminals.begin(), terminals.end()};
+  }
+
+ private:
+  [[nodiscard]] static DenseSide ToDenseSide(const Dfa &dfa,
+                                             const SymbolTable &symbols) {
+    auto states = FlatStates{};
+    states.emplace_back(dfa.GetS());
+    for (const auto &[u, trans_table] : dfa.GetDfaTable()) {
+      states.emplace_back(u);
+      for (const auto &v : trans_table | std::views::values) {
+        states.emplace_back(v);
+      }
+    }
+    std::ranges::sort(states);
+    states.erase(std::ranges::unique(states).begin(), states.end());
+    auto ids = std::unordered_map<StateId, uint32_t>{};
+    for (uint32_t i = 0; i < states.size(); ++i) {
+      ids.emplace(states[i], i);
+    }
+
+    const auto symbol_count = symbols.Size();
+    auto res = DenseSide{};
+    res.dead = static_cast<uint32_t>(states.size());
+    res.table.assign((states.size() + 1) * symbol_count, res.dead);
+    res.f.assign(states.size() + 1, false);
+    res.s = ids.at(dfa.GetS());
+    for (const auto &[u, trans_table] : dfa.GetDfaTable()) {
+      for (const auto &[t, v] : trans_table) {
+        res.table[ids.at(u) * symbol_count + symbols.Find(t)] = ids.at(v);
+      }
+    }
+    for (auto u : dfa.GetF()) {
+      if (auto it = ids.find(u); it != ids.end()) {
+        res.f[it->second] = true;
+      }
+    }
+    return res;
+  }
+
+  [[nodiscard]] static bool Accepts(ProductOp op, bool a, bool b) {
+    switch (op) {
+      case ProductOp::kIntersection:
+        return a && b;
+      case ProductOp::kUnion:
+        return a || b;
+      case ProductOp::kDifference:
+        return a && !b;
+      case ProductOp::kSymmetricDifference:
+        return a != b;
+    }
+    return false;
+  }
+
+  /**
+   * Whether no word leads from (u, v) to acceptance, judged by dead sides.
+   */
+  [[nodiscard]] bool IsHopeless(ProductOp op, uint32_t u, uint32_t v) const {
+    const auto a_dead = u == a_.dead;
+    const auto b_dead = v == b_.dead;
+    switch (op) {
+      case ProductOp::kIntersection:
+        return a_dead || b_dead;
+      case ProductOp::kDifference:
+        return a_dead;
+      case ProductOp::kUnion:
+      case ProductOp::kSymmetricDifference:
+        return a_dead && b_dead;
+    }
+    return true;
+  }
+
+  /**
+   * Breadth first search over reachable pairs, numbered 0, 1, ... in the
+   * order found, (s, s) being 0.
+   * @param on_edge Called as on_edge(u, t, v) for each edge, before v is
+   * explored.
+   * @param on_accept Called as on_accept(u) for each accepting pair.
+   * Either one returning true stops the search.
+   */
+  template <typename OnEdge, typename OnAccept>
+  void Explore(ProductOp op, OnEdge &&on_edge, OnAccept &&on_accept) const {
+    const auto symbol_count = symbols_.Size();
+    auto pairs = SubsetTable{};
+    pairs.Insert(std::array{a_.s, b_.s});
+    for (uint32_t i = 0; i < pairs.Size(); ++i) {
+      const auto pair = pairs.Get(i);
+      const auto u = pair[0];
+      const auto v = pair[1];
+      if (Accepts(op, a_.f[u], b_.f[v]) && on_accept(i)) {
+        return;
+      }
+      for (SymbolId t = 0; t < symbol_count; ++t) {
+        const auto next = std::array{a_.table[u * symbol_count + t],
+                                     b_.table[v * symbol_count + t]};
+        if (IsHopeless(op, next[0], next[1])) {
+          continue;
+        }
+        if (on_edge(i, t, pairs.Insert(next).first)) {
+          return;
+        }
+      }
+    }
+  }
+};
+
+[[nodiscard]] inline Dfa Intersection(const Dfa &a, const Dfa &b) {
+  return DfaProduct{a, b}.Build(ProductOp::kIntersection);
+}
+
+[[nodiscard]] inline Dfa Union(const Dfa &a, const Dfa &b) {
+  return DfaProduct{a, b}.Build(ProductOp::kUnion);
+}
+
+[[nodiscard]] inline Dfa Difference(const Dfa &a, const Dfa &b) {
+  return DfaProduct{a, b}.Build(ProductOp::kDifference);
+}
+
+[[nodiscard]] inline Dfa SymmetricDifference(const Dfa &a, const Dfa &b) {
+  return DfaProduct{a, b}.Build(ProductOp::kSymmetricDifference);
+}
+
+/**
+ * Words over alphabet not accepted by dfa, i.e. the difference of the
+ * one-state Dfa of alphabet* and dfa. Terminals of dfa not in alphabet are
+ * ignored.
+ */
+[[nodiscard]] inline Dfa Complement(const Dfa &dfa, const Terminals &alphabet) {
+  auto all_table = Dfa::DfaTable{};
+  for (const auto &t : alphabet) {
+    all_table[0].emplace(t, 0);
+  }
+  return DfaProduct{Dfa{std::move(all_table), 0, {0}}, dfa}.Build(
+      ProductOp::kDifference);
+}
+
+/**
+ * Complement over the terminals of dfa.
+ */
+[[nodiscard]] inline Dfa Complement(const Dfa &dfa) {
+  return Complement(dfa, DfaProduct::GetTerminals(dfa));
+}
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_DFA_PRODUCT_HPP
@@ -0,0 +1,188 @@
+#ifndef REGEX_FA_DFA_SCANNER_HPP
+#define REGEX_FA_DFA_SCANNER_HPP
+
+#include "dense-dfa-view.hpp"
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Resumable search over input arriving in chunks, with the matches of
+ * DenseDfaView::FindAll over the whole stream: leftmost-longest,
+ * non-overlapping, non-empty, with absolute offsets.
+ * Chunks are read in place and never kept, so instead of restarting after a
+ * failed attempt the scanner runs one thread per start position at once.
+ * Threads in the same state are merged into the earliest one unless a
+ * pending match could still end between their starts, which keeps about one
+ * thread per Dfa state. A match is reported once every attempt left of it
+ * has failed and it can grow no longer, so reports may lag the input.
+ * The DenseDfaView must outlive the DfaScanner.
+ */
+class DfaScanner {
+ public:
+  using DenseStateId = DenseDfaView::DenseStateId;
+
+ private:
+  static constexpr DenseStateId kDeadState = DenseDfaView::kDeadState;
+  static constexpr size_t kNoEnd = std::numeric_limits<size_t>::max();
+
+  struct Thread {
+    size_t begin{};
+    DenseStateId state{};  // kDeadState once the attempt can not grow
+    size_t end{kNoEnd};    // end of the longest match so far
+  };
+
+  DenseDfaView dfa_;
+  size_t offset_{0};
+  std::vector<Thread> threads_;  // ascending begin
+  std::vector<Thread> next_threads_;
+  std::vector<size_t> ends_;
+  std::vector<uint32_t> last_of_;  // state -> last kept thread, or kNoThread
+
+  static constexpr uint32_t kNoThread = std::numeric_limits<uint32_t>::max();
+
+ public:
+  explicit DfaScanner(const DenseDfaView &dfa)
+      : dfa_(dfa), last_of_(dfa.StateCount(), kNoThread) {}
+
+  /**
+   * Bytes consumed since the start of the stream.
+   */
+  [[nodiscard]] size_t GetOffset() const { return offset_; }
+
+  /**
+   * Number of attempts in flight, including finished ones waiting for an
+   * earlier attempt.
+   */
+  [[nodiscard]] size_t GetThreadCount() const { return threads_.size(); }
+
+  /**
+   * Consume the next chunk of the stream.
+   * @param on_match Called as on_match(Match) for each match known to be
+   * final, in order.
+   */
+  template <typename OnMatch>
+  void Feed(std::span<const std::byte> chunk, OnMatch &&on_match) {
+    for (auto byte : chunk) {
+      threads_.emplace_back(Thread{offset_, dfa_.GetS()});
+      ++offset_;
+      for (auto &thread : threads_) {
+        if (thread.state == kDeadState) {
+          continue;
+        }
+        thread.state = dfa_.Next(thread.state, byte);
+        if (thread.state != kDeadState && dfa_.IsAccepting(thread.state)) {
+          thread.end = offset_;
+        }
+      }
+      Resolve(on_match);
+      Merge();
+    }
+  }
+
+  template <typename OnMatch>
+  void Feed(std::string_view chunk, OnMatch &&on_match) {
+    Feed(DenseDfaView::AsBytes(chunk), std::forward<OnMatch>(on_match));
+  }
+
+  /**
+   * End the stream, report the remaining matches and start a new stream.
+   */
+  template <typename OnMatch>
+  void Finish(OnMatch &&on_match) {
+    for (auto &thread : threads_) {
+      thread.state = kDeadState;
+    }
+    Resolve(on_match);
+    assert(threads_.empty());
+    Reset();
+  }
+
+  /**
+   * Drop the current stream without reporting.
+   */
+  void Reset() {
+    offset_ = 0;
+    threads_.clear();
+  }
+
+ private:
+  /**
+   * Report matches of failed leftmost attempts, and drop attempts overlapped
+   * by the leftmost match.
+   */
+  template <typename OnMatch>
+  void Resolve(OnMatch &on_match) {
+    size_t first = 0;
+    auto cut = size_t{0};  // attempts beginning before cut are dropped
+    for (; first < threads_.size(); ++first) {
+      const auto &thread = threads_[first];
+      if (thread.begin < cut) {
+        continue;
+      }
+      if (thread.state != kDeadState) {
+        if (thread.end != kNoEnd) {
+          // Leftmost and matched, only a longer match can come.
+          cut = thread.end;
+          threads_.erase(threads_.begin(), threads_.begin() + first);
+          threads_.erase(
+              std::remove_if(threads_.begin() + 1, threads_.end(),
+                             [cut](const auto &t) { return t.begin < cut; }),
+              threads_.end());
+          return;
+        }
+        break;
+      }
+      if (thread.end != kNoEnd) {
+        on_match(Match{thread.begin, thread.end});
+        cut = thread.end;
+      }
+    }
+    threads_.erase(threads_.begin(), threads_.begin() + first);
+  }
+
+  /**
+   * Merge live threads in the same state. A later thread is only dropped if
+   * no match so far ends after the begin of the kept one and not after its
+   * own begin, as such a match would cut the kept one but not it.
+   */
+  void Merge() {
+    ends_.clear();
+    for (const auto &thread : threads_) {
+      if (thread.end != kNoEnd) {
+        ends_.emplace_back(thread.end);
+      }
+    }
+
+    next_threads_.clear();
+    for (const auto &thread : threads_) {
+      if (thread.state == kDeadState) {
+        if (thread.end != kNoEnd) {
+          next_threads_.emplace_back(thread);
+        }
+        continue;
+      }
+      auto &last = last_of_[thread.state];
+      if (last != kNoThread) {
+        const auto kept_begin = next_threads_[last].begin;
+        if (std::ranges::none_of(ends_, [&](auto end) {
+              return kept_begin < end && end <= thread.begin;
+            })) {
+          continue;
+        }
+      }
+      last = static_cast<uint32_t>(next_threads_.size());
+      next_threads_.emplace_back(thread);
+    }
+    for (const auto &thread : next_threads_) {
+      if (thread.state != kDeadState) {
+        last_of_[thread.state] = kNoThread;
+      }
+    }
+    std::swap(threads_, next_threads_);
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_DFA_SCANNER_HPP
@@ -1,7 +1,12 @@
 #ifndef REGEX_FA_DFA_HPP
 #define REGEX_FA_DFA_HPP
 
+#include "alphabet.hpp"
+#include "fa-graph.hpp"
 #include "fa-include.hpp"
+#include "refinable-partition.hpp"
+#include "stats.hpp"
+#include "thread-pool.hpp"
 
 namespace regex_fa {
 
@@ -50,24 +55,39 @@ struct HopcroftLog {
   std::vector<HopcroftSplitLog> hopcroftSplitLogs{};
 };
 
-class DfaLogger {
+/**
+ * Receives the steps of Dfa::Minimize(HopcroftSink &) as they happen, so
+ * nothing accumulates unless the sink keeps it. Each minimization has its
+ * own sink, so minimizations on several threads trace independently.
+ */
+class HopcroftSink {
+ public:
+  virtual ~HopcroftSink() = default;
+
+  virtual void OnSource([[maybe_unused]] const FlatDfa &source) {}
+  virtual void OnSplit([[maybe_unused]] HopcroftSplitLog split_log) {}
+  virtual void OnTarget([[maybe_unused]] const FlatDfa &target) {}
+};
+
+/**
+ * HopcroftSink that collects one minimization into a HopcroftLog.
+ */
+class DfaLogger : public HopcroftSink {
  public:
   HopcroftLog hopcroft_log{};
 
-  static DfaLogger &GetInstance() {
-    static DfaLogger dfa_logger{};
-    return dfa_logger;
+  void OnSource(const FlatDfa &source) override {
+    hopcroft_log = {};
+    hopcroft_log.source = source;
   }
 
- private:
-  DfaLogger() = default;
-
- public:
-  DfaLogger(const DfaLogger &) = delete;
-  DfaLogger(const DfaLogger &&) = delete;
-  DfaLogger &operator=(const DfaLogger &) = delete;
+  void OnSplit(HopcroftSplitLog split_log) override {
+    hopcroft_log.hopcroftSplitLogs.emplace_back(std::move(split_log));
+  }
 
-  void ClearHopcroftLog() { hopcroft_log = {}; }
+  void OnTarget(const FlatDfa &target) override {
+    hopcroft_log.target = target;
+  }
 };
 
 class Dfa {
@@ -79,14 +99,50 @@ class Dfa {
   using TransTable = std::unordered_map<Terminal, StateId>;
   using DfaTable = std::unordered_map<StateId, TransTable>;
 
+  /**
+   * States and terminals numbered 0, 1, ... in ascending order, and the
+   * transitions of each state sorted by terminal.
+   */
+  struct Index {
+    struct OutEdge {
+      uint32_t terminal{};
+      uint32_t target{};
+
+      auto operator<=>(const OutEdge &) const = default;
+    };
+
+    FlatStates states{};  // s and f included
+    std::unordered_map<StateId, uint32_t> stateIndex{};
+    std::vector<Terminal> terminals{};
+    std::unordered_map<Terminal, uint32_t> terminalIndex{};
+    std::vector<uint32_t> outFirst{0};  // u -> range in outEdges
+    std::vector<OutEdge> outEdges{};
+
+    [[nodiscard]] std::span<const OutEdge> GetOutEdges(uint32_t u) const {
+      return {outEdges.data() + outFirst[u], outEdges.data() + outFirst[u + 1]};
+    }
+  };
+
  private:
+  struct IndexCache {
+    std::once_flag once;
+    Index index;
+  };
+
   DfaTable dfa_table_;
   StateId s_;
   States f_;
+  AcceptTable accept_;
+  // Built on first use. A Dfa never changes its states or transitions, so
+  // copies share it.
+  std::shared_ptr<IndexCache> index_cache_ = std::make_shared<IndexCache>();
 
  public:
-  Dfa(DfaTable table, StateId s, States f)
-      : dfa_table_(std::move(table)), s_(s), f_(std::move(f)) {
+  Dfa(DfaTable table, StateId s, States f, AcceptTable accept = {})
+      : dfa_table_(std::move(table)),
+        s_(s),
+        f_(std::move(f)),
+        accept_(std::move(accept)) {
     FixDfaTable();
   }
 
@@ -107,17 +163,100 @@ class Dfa {
    * Fix v is not in key.
    */
   void FixDfaTable() {
-    for (auto stateId : GetStates()) {
-      dfa_table_.try_emplace(stateId);
+    auto targets = FlatStates{};
+    for (const auto &trans_table : dfa_table_ | std::views::values) {
+      for (const auto &v : trans_table | std::views::values) {
+        targets.emplace_back(v);
+      }
+    }
+    for (auto v : targets) {
+      dfa_table_.try_emplace(v);
     }
   }
 
   [[nodiscard]] const DfaTable &GetDfaTable() const { return dfa_table_; }
   [[nodiscard]] StateId GetS() const { return s_; }
   [[nodiscard]] const States &GetF() const { return f_; }
+  [[nodiscard]] const AcceptTable &GetAcceptTable() const { return accept_; }
 
+  /**
+   * Index of this Dfa, built once on first use and shared by its copies.
+   * Safe to call from several threads.
+   */
+  [[nodiscard]] const Index &GetIndex() const {
+    std::call_once(index_cache_->once,
+                   [this] { index_cache_->index = BuildIndex(); });
+    return index_cache_->index;
+  }
+
+  /**
+   * Patterns accepted by state_id, empty if it is not final.
+   */
+  [[nodiscard]] std::span<const PatternId> GetPatterns(StateId state_id) const {
+    if (!f_.contains(state_id)) {
+      return {};
+    }
+    if (auto it = accept_.find(state_id); it != accept_.end()) {
+      return it->second;
+    }
+    return kDefaultPatterns;
+  }
+
+  /**
+   * Minimal Dfa. States accepting different patterns are never merged.
+   */
   [[nodiscard]] Dfa Minimize() const { return Hopcroft(); }
 
+  /**
+   * Same as Minimize(), with the partition, inverse transitions and other
+   * scratch taken from resource. Only the result and GetIndex() are
+   * allocated elsewhere.
+   */
+  [[nodiscard]] Dfa Minimize(std::pmr::memory_resource &resource) const {
+    return Hopcroft(resource);
+  }
+
+  /**
+   * Same as Minimize(), reporting every split to sink as it happens.
+   */
+  [[nodiscard]] Dfa Minimize(HopcroftSink &sink) const {
+    return Hopcroft(*std::pmr::get_default_resource(), &sink);
+  }
+
+  /**
+   * Minimize on thread_count threads (0 means one per core) by parallel
+   * Moore rounds. The result equals Minimize(). Nothing is logged.
+   */
+  [[nodiscard]] Dfa Minimize(size_t thread_count) const {
+    if (thread_count == 1) {
+      return Minimize();
+    }
+    return ParallelMoore(thread_count);
+  }
+
+  /**
+   * Terminals that go to the same state from every state, grouped into
+   * classes. A missing transition only equals a missing transition.
+   */
+  [[nodiscard]] TerminalClasses GetTerminalClasses() const {
+    const auto &index = GetIndex();
+    // Interned in ascending order, so symbol i is index.terminals[i].
+    auto symbols = SymbolTable{};
+    for (const auto &t : index.terminals) {
+      symbols.Intern(t);
+    }
+    auto classes = SymbolClasses{symbols.Size()};
+    auto edges = std::vector<SymbolClasses::Edge>{};
+    for (uint32_t u = 0; u < index.states.size(); ++u) {
+      edges.clear();
+      for (const auto &[t, v] : index.GetOutEdges(u)) {
+        edges.emplace_back(v, t);
+      }
+      classes.Refine(edges);
+    }
+    return classes.GetTerminalClasses(symbols);
+  }
+
   /*
    * Rename state id in bfs order.
    */
@@ -152,8 +291,59 @@ class Dfa {
     for (const auto &state_id : f_) {
       f.insert(new_id_table[state_id]);
     }
+    AcceptTable accept{};
+    for (const auto &[state_id, patterns] : accept_) {
+      accept.emplace(new_id_table[state_id], patterns);
+    }
 
-    return {dfa_table, new_id_table[s_], f};
+    return {dfa_table, new_id_table[s_], f, accept};
+  }
+
+  /**
+   * Drop states that are not reachable from s or reach no final state, and
+   * the edges into them. s is always kept, state ids are unchanged.
+   * Shrinks the input of Minimize().
+   */
+  [[nodiscard]] Dfa Trim() const {
+    const auto &dense_index = GetIndex();
+    const auto &index = dense_index.stateIndex;
+    auto edges = std::vector<CsrFaGraph::Edge>{};
+    for (uint32_t u = 0; u < dense_index.states.size(); ++u) {
+      for (const auto &edge : dense_index.GetOutEdges(u)) {
+        edges.emplace_back(u, edge.target);
+      }
+    }
+    auto finals = std::vector<uint32_t>{};
+    for (auto state_id : f_) {
+      finals.emplace_back(index.at(state_id));
+    }
+    const auto s = std::array{index.at(s_)};
+    const auto useful =
+        CsrFaGraph{dense_index.states.size(), edges}.GetUseful(s, finals);
+
+    auto dfa_table = DfaTable{{s_, {}}};
+    for (const auto &[u, trans_table] : dfa_table_) {
+      if (!useful.Contains(index.at(u))) {
+        continue;
+      }
+      auto &new_trans_table = dfa_table[u];
+      for (const auto &[t, v] : trans_table) {
+        if (useful.Contains(index.at(v))) {
+          new_trans_table.emplace(t, v);
+        }
+      }
+    }
+    auto f = States{};
+    auto accept = AcceptTable{};
+    for (auto state_id : f_) {
+      if (useful.Contains(index.at(state_id))) {
+        f.emplace(state_id);
+        if (auto it = accept_.find(state_id); it != accept_.end()) {
+          accept.emplace(*it);
+        }
+      }
+    }
+    return {std::move(dfa_table), s_, std::move(f), std::move(accept)};
   }
 
   [[nodiscard]] FlatDfa ToFlatDfa() const {
@@ -162,9 +352,7 @@ class Dfa {
     for (auto f : f_) {
       flatDfa.f.emplace_back(f);
     }
-    for (auto state : GetStates()) {
-      flatDfa.states.emplace_back(state);
-    }
+    flatDfa.states = GetStates();
 
     for (auto &[u, transTable] : dfa_table_) {
       for (auto &[terminal, v] : transTable) {
@@ -175,235 +363,429 @@ class Dfa {
   }
 
  private:
-  using SplitId = StateId;
-
-  /**
-   * Split should not be empty.
-   */
-  using Split = States;
-
-  /**
-   * For $key state, it is in $value split.
-   */
-  using SplitIndexTable = std::unordered_map<StateId, SplitId>;
-
-  /**
-   * For $key split, it contains $value states.
-   */
-  using SplitTable = std::unordered_map<SplitId, Split>;
+  using SplitId = RefinablePartition::BlockId;
+
+  static HopcroftSplit ToHopcroftSplit(const RefinablePartition &partition,
+                                       std::span<const StateId> states,
+                                       SplitId b) {
+    auto res = HopcroftSplit{};
+    res.splitId = b;
+    for (auto e : partition.Elements(b)) {
+      res.states.emplace_back(states[e]);
+    }
+    return res;
+  }
 
-#ifdef REGEX_FA_LOGGER
   static HopcroftFlatSplitTable ToHopcroftFlatSplitTable(
-      const SplitTable &split_table) {
+      const RefinablePartition &partition, std::span<const StateId> states) {
     auto res = HopcroftFlatSplitTable{};
-    for (const auto &[split_id, split] : split_table) {
-      res.splits.emplace_back(split_id, split);
+    for (SplitId b = 0; b < partition.BlockCount(); ++b) {
+      res.splits.emplace_back(ToHopcroftSplit(partition, states, b));
     }
     return res;
   }
-#endif
 
-  /**
-   * Try to make new splits from split.
-   * @param split_index_table
-   * @param split The split works on. Split must not be empty.
-   * @param free_split_id SplitId free to use.
-   * @return Return new splits. If there is no new split, return split
-   * itself.
-   */
-  [[nodiscard]] SplitTable HopcroftSplit(
-      const SplitIndexTable &split_index_table, const Split &split,
-      SplitId &free_split_id) const {
-    // Get terminals used by current split.
-    auto terminals = GetTerminals(split);
-
-    // For each terminal, see if it can make new split.
-    for (const auto &terminal : terminals) {
-      auto curSplitTable = SplitTable{};
-
-      // For u --t-> u, u may goto empty.
-      // Goto empty is different from goto v, which will need a split_id.
-      auto emptySplitId = std::optional<SplitId>{std::nullopt};
-
-      for (const auto &u : split) {
-        auto &trans_table = dfa_table_.at(u);
-
-        // If goto v.
-        if (trans_table.contains(terminal)) {
-          auto v = trans_table.at(terminal);
-          auto vSplitId = split_index_table.at(v);
-          curSplitTable.try_emplace(vSplitId);
-          curSplitTable[vSplitId].emplace(u);
-        }
-        // If goto empty.
-        else {
-          if (!emptySplitId.has_value()) {
-            // Use free_split_id as SplitId for empty split temporarily.
-            emptySplitId.emplace(free_split_id);
-            curSplitTable[emptySplitId.value()] = {};
-          }
-          curSplitTable[emptySplitId.value()].emplace(u);
-        }
+  [[nodiscard]] Index BuildIndex() const {
+    auto res = Index{};
+    res.states.emplace_back(s_);
+    res.states.insert(res.states.end(), f_.begin(), f_.end());
+    for (const auto &[u, trans_table] : dfa_table_) {
+      res.states.emplace_back(u);
+      for (const auto &[t, v] : trans_table) {
+        res.states.emplace_back(v);
+        res.terminals.emplace_back(t);
       }
+    }
+    std::ranges::sort(res.states);
+    res.states.erase(std::ranges::unique(res.states).begin(), res.states.end());
+    std::ranges::sort(res.terminals);
+    res.terminals.erase(std::ranges::unique(res.terminals).begin(),
+                        res.terminals.end());
+
+    res.stateIndex.reserve(res.states.size());
+    for (uint32_t i = 0; i < res.states.size(); ++i) {
+      res.stateIndex.emplace(res.states[i], i);
+    }
+    res.terminalIndex.reserve(res.terminals.size());
+    for (uint32_t i = 0; i < res.terminals.size(); ++i) {
+      res.terminalIndex.emplace(res.terminals[i], i);
+    }
 
-      // Success
-      if (curSplitTable.size() > 1) {
-#ifdef REGEX_FA_LOGGER
-        auto hopcroft_split_log = HopcroftSplitLog{};
-        hopcroft_split_log.splitTerminal = terminal;
-        DfaLogger::GetInstance().hopcroft_log.hopcroftSplitLogs.emplace_back(
-            hopcroft_split_log);
-#endif
-        auto res = SplitTable{};
-        for (const auto &newSplit : curSplitTable | std::views::values) {
-          res[free_split_id++] = newSplit;
+    res.outFirst.reserve(res.states.size() + 1);
+    for (auto state_id : res.states) {
+      if (auto it = dfa_table_.find(state_id); it != dfa_table_.end()) {
+        for (const auto &[t, v] : it->second) {
+          res.outEdges.emplace_back(res.terminalIndex.at(t),
+                                    res.stateIndex.at(v));
         }
-        return res;
       }
+      std::sort(res.outEdges.begin() + res.outFirst.back(),
+                res.outEdges.end());
+      res.outFirst.emplace_back(static_cast<uint32_t>(res.outEdges.size()));
     }
-
-    // Return split itself if there is no new split.
-    auto res = SplitTable{};
-    res.emplace(split_index_table.at(*split.begin()), split);
     return res;
   }
 
-  [[nodiscard]] Dfa Hopcroft() const {
-#ifdef REGEX_FA_LOGGER
-    DfaLogger::GetInstance().ClearHopcroftLog();
-    DfaLogger::GetInstance().hopcroft_log.source = ToFlatDfa();
-#endif
-
-    auto split_table = SplitTable{};
-    auto split_index_table = SplitIndexTable{};
-    SplitId free_split_id{0};
-
-    // split states into final states and non-final states
-    Split final_states, none_final_states;
-    for (const auto &state_id : GetStates()) {
-      f_.contains(state_id) ? final_states.emplace(state_id)
-                            : none_final_states.emplace(state_id);
-    }
-
-    auto work_queue = std::queue<Split>{};
-    auto wait_queue = std::queue<Split>{};
-
-    /**
-     * Insert new split into split_table, split_index_table and work_queue.
-     */
-    auto InsertSplit = [&split_table, &split_index_table, &free_split_id,
-                        &work_queue](const Split &split) -> void {
-      if (split.empty()) {
-        return;
-      }
-      auto split_id = free_split_id++;
-      split_table[split_id] = split;
+  /**
+   * Initial classes of minimization: 0 for non-final states, then one class
+   * per set of accepted patterns, in order of the sets.
+   * @return Class of each of index.states, and the number of classes.
+   */
+  [[nodiscard]] std::pair<std::vector<uint32_t>, uint32_t> GetAcceptClasses(
+      const Index &index, std::pmr::memory_resource &resource) const {
+    auto class_of_patterns = std::pmr::map<PatternIds, uint32_t>{&resource};
+    for (auto state_id : f_) {
+      const auto patterns = GetPatterns(state_id);
+      class_of_patterns.try_emplace(PatternIds{patterns.begin(), patterns.end()});
+    }
+    uint32_t class_count = 1;
+    for (auto &c : class_of_patterns | std::views::values) {
+      c = class_count++;
+    }
 
-      for (const auto &state_id : split) {
-        split_index_table[state_id] = split_id;
+    auto classes = std::vector<uint32_t>(index.states.size(), 0);
+    for (uint32_t i = 0; i < index.states.size(); ++i) {
+      if (const auto patterns = GetPatterns(index.states[i]); !patterns.empty()) {
+        classes[i] =
+            class_of_patterns.at(PatternIds{patterns.begin(), patterns.end()});
       }
+    }
+    return {std::move(classes), class_count};
+  }
 
-      work_queue.emplace(split);
+  /**
+   * Dfa of the equivalence classes of states. Classes are numbered in state
+   * order, so equal partitions give equal results.
+   * @param block_of block_of(i) is the class of index.states[i].
+   */
+  template <typename BlockOf>
+  [[nodiscard]] Dfa Quotient(const Index &index, size_t block_count,
+                             BlockOf &&block_of,
+                             std::pmr::memory_resource &resource) const {
+    constexpr auto kNoId = std::numeric_limits<StateId>::max();
+    auto new_ids = std::pmr::vector<StateId>(block_count, kNoId, &resource);
+    auto representatives = std::pmr::vector<StateId>{&resource};
+    for (uint32_t i = 0; i < index.states.size(); ++i) {
+      auto &new_id = new_ids[block_of(i)];
+      if (new_id == kNoId) {
+        new_id = representatives.size();
+        representatives.emplace_back(index.states[i]);
+      }
+    }
+    auto NewId = [&](StateId state_id) -> StateId {
+      return new_ids[block_of(index.stateIndex.at(state_id))];
     };
 
-    InsertSplit(none_final_states);
-    InsertSplit(final_states);
-
-    while (!work_queue.empty()) {
-      auto cur_split = std::move(work_queue.front());
-      work_queue.pop();
+    auto dfa_table = DfaTable{};
+    for (StateId new_id = 0; new_id < representatives.size(); ++new_id) {
+      auto &trans_table = dfa_table[new_id];
+      // Any state of the class represents it.
+      if (auto it = dfa_table_.find(representatives[new_id]);
+          it != dfa_table_.end()) {
+        for (const auto &[t, v] : it->second) {
+          trans_table[t] = NewId(v);
+        }
+      }
+    }
 
-      // Split is not empty, use first state to find split_id.
-      auto cur_split_id = split_index_table[*cur_split.begin()];
+    auto f = States{};
+    for (const auto &state_id : f_) {
+      f.emplace(NewId(state_id));
+    }
+    // States of a class accept the same patterns.
+    auto accept = AcceptTable{};
+    for (const auto &[state_id, patterns] : accept_) {
+      accept.try_emplace(NewId(state_id), patterns);
+    }
+    return {std::move(dfa_table), NewId(s_), std::move(f), std::move(accept)};
+  }
 
-      // Split with size 1 can not make new cur_split.
-      if (cur_split.size() == 1) {
-        continue;
+  /**
+   * Hopcroft's algorithm on a refinable partition, O(m log n).
+   * Initial splits are the non-final states and the final states of each set
+   * of patterns.
+   * Missing transitions behave as going to an implicit sink, which is its own
+   * initial split and never used as a splitter, so u --t-> (nothing) stays
+   * different from u --t-> v.
+   * A splitter is a whole split. It refines by every terminal entering it, and
+   * each new split queues only the smaller half.
+   * All scratch memory comes from upstream. The split tables sent to sink
+   * are built only if there is one.
+   */
+  [[nodiscard]] Dfa Hopcroft(
+      std::pmr::memory_resource &upstream = *std::pmr::get_default_resource(),
+      HopcroftSink *sink = nullptr) const {
+    if (sink != nullptr) {
+      sink->OnSource(ToFlatDfa());
+    }
+    const auto timer = StatsTimer{StatPhase::kMinimize};
+    auto stats_resource = StatsResource{upstream};
+    auto &resource = stats_resource.Get();
+
+    const auto &index = GetIndex();
+    const auto &states = index.states;
+    const auto &terminals = index.terminals;
+
+    // Inverse transitions, grouped by target: in_edges[in_first[v],
+    // in_first[v + 1]) are all u --t-> v.
+    struct InEdge {
+      uint32_t terminal;
+      uint32_t source;
+    };
+    auto in_first =
+        std::pmr::vector<uint32_t>(states.size() + 1, 0, &resource);
+    for (const auto &edge : index.outEdges) {
+      ++in_first[edge.target + 1];
+    }
+    for (size_t i = 0; i < states.size(); ++i) {
+      in_first[i + 1] += in_first[i];
+    }
+    auto in_edges = std::pmr::vector<InEdge>(in_first.back(), &resource);
+    {
+      auto cursor = std::pmr::vector<uint32_t>{in_first, &resource};
+      for (uint32_t u = 0; u < states.size(); ++u) {
+        for (const auto &[t, v] : index.GetOutEdges(u)) {
+          in_edges[cursor[v]++] = {t, u};
+        }
       }
+    }
 
-      auto new_split_table =
-          HopcroftSplit(split_index_table, cur_split, free_split_id);
+    // Split states into non-final states and final states by patterns.
+    const auto [classes, class_count] = GetAcceptClasses(index, resource);
+    auto partition = RefinablePartition{classes, class_count, &resource};
 
-      // No new spilt.
-      if (new_split_table.size() == 1) {
-        // Move to wait Queue. It may make new split when other new split occur.
-        wait_queue.emplace(std::move(cur_split));
-        continue;
-      }
+    auto work_list = std::pmr::vector<SplitId>{&resource};
+    for (SplitId b = 0; b < partition.BlockCount(); ++b) {
+      work_list.emplace_back(b);
+    }
 
-#ifdef REGEX_FA_LOGGER
-      auto &hopcroft_split_log =
-          DfaLogger::GetInstance().hopcroft_log.hopcroftSplitLogs.back();
-      hopcroft_split_log.split = {cur_split_id, cur_split};
-      hopcroft_split_log.source = ToHopcroftFlatSplitTable(split_table);
-#endif
-
-      // New split
-      split_table.erase(cur_split_id);  // Remove old split.
-      // Add new splits.
-      for (const auto &new_split : new_split_table | std::views::values) {
-        InsertSplit(new_split);
-#ifdef REGEX_FA_LOGGER
-        hopcroft_split_log.newSplits.emplace_back(
-            split_index_table[*new_split.begin()], new_split);
-#endif
-      }
+    auto last_split_table = HopcroftFlatSplitTable{};
+    if (sink != nullptr) {
+      last_split_table = ToHopcroftFlatSplitTable(partition, states);
+    }
 
-#ifdef REGEX_FA_LOGGER
-      hopcroft_split_log.target = ToHopcroftFlatSplitTable(split_table);
-#endif
+    // Scratch, reused by every splitter.
+    auto splitter = std::pmr::vector<uint32_t>{&resource};
+    auto sources = std::pmr::vector<std::pmr::vector<uint32_t>>(
+        terminals.size(), &resource);
+    auto used_terminals = std::pmr::vector<uint32_t>{&resource};
+
+    uint64_t splitter_count = 0;
+    uint64_t split_count = 0;
+    while (!work_list.empty()) {
+      auto splitter_id = work_list.back();
+      work_list.pop_back();
+      ++splitter_count;
+
+      // The splitter itself may be split below, work on a copy.
+      const auto elements = partition.Elements(splitter_id);
+      splitter.assign(elements.begin(), elements.end());
+
+      for (auto v : splitter) {
+        for (auto i = in_first[v]; i < in_first[v + 1]; ++i) {
+          const auto &[t, u] = in_edges[i];
+          if (sources[t].empty()) {
+            used_terminals.emplace_back(t);
+          }
+          sources[t].emplace_back(u);
+        }
+      }
 
-      // When new split occurs, previous split may also be able to be split.
-      while (!wait_queue.empty()) {
-        work_queue.emplace(std::move(wait_queue.front()));
-        wait_queue.pop();
+      for (auto t : used_terminals) {
+        for (auto u : sources[t]) {
+          partition.Mark(u);
+        }
+        sources[t].clear();
+
+        partition.SplitMarked([&](SplitId old_id, SplitId new_id) {
+          // The smaller half is always the new split. If the old split is
+          // still waiting, both halves are now waiting.
+          work_list.emplace_back(new_id);
+          ++split_count;
+          if (sink == nullptr) {
+            return;
+          }
+          auto hopcroft_split_log = HopcroftSplitLog{};
+          hopcroft_split_log.splitTerminal = terminals[t];
+          hopcroft_split_log.source = std::move(last_split_table);
+          hopcroft_split_log.newSplits.emplace_back(
+              ToHopcroftSplit(partition, states, old_id));
+          hopcroft_split_log.newSplits.emplace_back(
+              ToHopcroftSplit(partition, states, new_id));
+          hopcroft_split_log.split.splitId = old_id;
+          for (const auto &new_split : hopcroft_split_log.newSplits) {
+            hopcroft_split_log.split.states.insert(
+                hopcroft_split_log.split.states.end(),
+                new_split.states.begin(), new_split.states.end());
+          }
+          std::ranges::sort(hopcroft_split_log.split.states);
+          last_split_table = ToHopcroftFlatSplitTable(partition, states);
+          hopcroft_split_log.target = last_split_table;
+          sink->OnSplit(std::move(hopcroft_split_log));
+        });
       }
+      used_terminals.clear();
     }
+    Stats::Add(StatCounter::kRefinementRounds, splitter_count);
+    Stats::Add(StatCounter::kSplits, split_count);
+    Stats::Max(StatCounter::kPeakBlocks, partition.BlockCount());
+
+    auto res =
+        Quotient(index, partition.BlockCount(),
+                 [&partition](uint32_t i) { return partition.BlockOf(i); },
+                 resource);
+    if (sink != nullptr) {
+      sink->OnTarget(res.ToFlatDfa());
+    }
+    return res;
+  }
 
-    // Build new dfa from split table.
-    auto dfa_table = DfaTable{};
-    auto s = StateId{split_index_table[s_]};
-    auto f = States{};
+  /**
+   * Moore's algorithm with every round run in parallel, O(n m) in the worst
+   * case but each round is embarrassingly parallel.
+   * A round gives every state the signature (class, terminals, classes of
+   * targets), hashed in parallel, then groups equal signatures into the new
+   * classes. Grouping is sharded by hash, each shard numbers its own classes
+   * in state order, so the numbering does not depend on scheduling. Rounds
+   * stop once the number of classes stays the same.
+   * Missing transitions go to an implicit sink with a class of its own, as in
+   * Hopcroft().
+   */
+  [[nodiscard]] Dfa ParallelMoore(size_t thread_count) const {
+    const auto timer = StatsTimer{StatPhase::kMinimize};
+    const auto &index = GetIndex();
+    const auto n = static_cast<uint32_t>(index.states.size());
+    constexpr auto kNoClass = std::numeric_limits<uint32_t>::max();
+
+    // out_edges[out_first[u], out_first[u + 1]) are all u --t-> v, sorted by
+    // t.
+    const auto &out_first = index.outFirst;
+    const auto &out_edges = index.outEdges;
+
+    auto pool = ThreadPool{thread_count};
+    const auto shard_count = pool.Size() * 4;
+    constexpr size_t kGrain = 1024;
+
+    auto classes =
+        GetAcceptClasses(index, *std::pmr::get_default_resource()).first;
+    size_t class_count = std::unordered_set<uint32_t>{classes.begin(),
+                                                      classes.end()}
+                             .size();
+
+    auto hashes = std::vector<uint64_t>(n);
+    auto new_classes = std::vector<uint32_t>(n);
+    // States of each shard in ascending order.
+    auto shard_first = std::vector<uint32_t>(shard_count + 1);
+    auto shard_states = std::vector<uint32_t>(n);
+    // Per shard: hash -> last class with it, class -> previous class with the
+    // same hash, and class -> representative state.
+    struct Shard {
+      std::unordered_map<uint64_t, uint32_t> firstClass;
+      std::vector<uint32_t> nextClass;
+      std::vector<uint32_t> representatives;
+    };
+    auto shards = std::vector<Shard>(shard_count);
+    auto ShardOf = [shard_count](uint64_t hash) {
+      return static_cast<uint32_t>((hash >> 32) % shard_count);
+    };
 
-    // Build dfa_table.
-    for (const auto &[split_id, split] : split_table) {
-      dfa_table[split_id] = {};
+    auto SameSignature = [&](uint32_t u, uint32_t v) {
+      if (classes[u] != classes[v] ||
+          out_first[u + 1] - out_first[u] != out_first[v + 1] - out_first[v]) {
+        return false;
+      }
+      for (uint32_t i = out_first[u], j = out_first[v]; i < out_first[u + 1];
+           ++i, ++j) {
+        if (out_edges[i].terminal != out_edges[j].terminal ||
+            classes[out_edges[i].target] != classes[out_edges[j].target]) {
+          return false;
+        }
+      }
+      return true;
+    };
 
-      // Split is not empty.
-      // Use the first element as a representative of the split.
-      auto u = *split.cbegin();
+    while (true) {
+      pool.ParallelFor(n, kGrain, [&](size_t u, size_t) {
+        auto hash = uint64_t{classes[u]};
+        for (auto i = out_first[u]; i < out_first[u + 1]; ++i) {
+          for (uint64_t x : {out_edges[i].terminal,
+                             classes[out_edges[i].target]}) {
+            hash = (hash ^ x) * 0x9e3779b97f4a7c15;
+            hash ^= hash >> 29;
+          }
+        }
+        hashes[u] = hash;
+      });
 
-      // Add to dfa table
-      for (const auto &[t, v] : dfa_table_.at(u)) {
-        dfa_table[split_id][t] = split_index_table[v];
+      std::ranges::fill(shard_first, 0);
+      for (uint32_t u = 0; u < n; ++u) {
+        ++shard_first[ShardOf(hashes[u]) + 1];
+      }
+      for (size_t k = 0; k < shard_count; ++k) {
+        shard_first[k + 1] += shard_first[k];
+      }
+      {
+        auto cursor = shard_first;
+        for (uint32_t u = 0; u < n; ++u) {
+          shard_states[cursor[ShardOf(hashes[u])]++] = u;
+        }
       }
-    }
 
-    // Build f.
-    for (const auto &state_id : f_) {
-      f.emplace(split_index_table[state_id]);
+      // Classes local to each shard.
+      pool.ParallelFor(shard_count, 1, [&](size_t k, size_t) {
+        auto &shard = shards[k];
+        shard.firstClass.clear();
+        shard.nextClass.clear();
+        shard.representatives.clear();
+        for (auto i = shard_first[k]; i < shard_first[k + 1]; ++i) {
+          const auto u = shard_states[i];
+          auto [it, inserted] =
+              shard.firstClass.try_emplace(hashes[u], kNoClass);
+          auto c = it->second;
+          while (c != kNoClass && !SameSignature(u, shard.representatives[c])) {
+            c = shard.nextClass[c];
+          }
+          if (c == kNoClass) {
+            c = static_cast<uint32_t>(shard.representatives.size());
+            shard.representatives.emplace_back(u);
+            shard.nextClass.emplace_back(it->second);
+            it->second = c;
+          }
+          new_classes[u] = c;
+        }
+      });
+
+      auto shard_offsets = std::vector<uint32_t>(shard_count + 1, 0);
+      for (size_t k = 0; k < shard_count; ++k) {
+        shard_offsets[k + 1] = shard_offsets[k] +
+                               static_cast<uint32_t>(shards[k].representatives.size());
+      }
+      pool.ParallelFor(n, kGrain, [&](size_t u, size_t) {
+        new_classes[u] += shard_offsets[ShardOf(hashes[u])];
+      });
+
+      const auto new_class_count = size_t{shard_offsets.back()};
+      std::swap(classes, new_classes);
+      Stats::Add(StatCounter::kRefinementRounds);
+      if (new_class_count == class_count) {
+        break;
+      }
+      Stats::Add(StatCounter::kSplits, new_class_count - class_count);
+      class_count = new_class_count;
     }
+    Stats::Max(StatCounter::kPeakBlocks, class_count);
 
-    auto res = Dfa{dfa_table, s, f};
-#ifdef REGEX_FA_LOGGER
-    DfaLogger::GetInstance().hopcroft_log.target = res.ToFlatDfa();
-#endif
-    return res;
+    return Quotient(index, class_count,
+                    [&classes](uint32_t u) { return classes[u]; },
+                    *std::pmr::get_default_resource());
   }
 
   /**
-   * Get all states from dfa table.
+   * Get all states, ascending.
    * @return
    */
-  [[nodiscard]] States GetStates() const {
-    auto res = States();
-    for (auto &[u, transTable] : dfa_table_) {
-      for (const auto &v : transTable | std::views::values) {
-        res.insert(u);
-        res.insert(v);
-      }
-    }
-    return res;
+  [[nodiscard]] const FlatStates &GetStates() const {
+    return GetIndex().states;
   }
 
   /**
@@ -412,9 +794,10 @@ class Dfa {
    * @return
    */
   [[nodiscard]] Terminals GetTerminals(StateId state_id) const {
+    const auto &index = GetIndex();
     auto res = Terminals{};
-    for (const auto &terminal : dfa_table_.at(state_id) | std::views::keys) {
-      res.emplace(terminal);
+    for (const auto &edge : index.GetOutEdges(index.stateIndex.at(state_id))) {
+      res.emplace(index.terminals[edge.terminal]);
     }
     return res;
   }
@@ -450,14 +833,9 @@ class Dfa {
    * @param
    * @return
    */
-  [[nodiscard]] Terminals GetTerminals() {
-    auto res = Terminals{};
-    for (const auto &trans_table : dfa_table_ | std::views::values) {
-      for (const auto &t : trans_table | std::views::keys) {
-        res.emplace(t);
-      }
-    }
-    return res;
+  [[nodiscard]] Terminals GetTerminals() const {
+    const auto &terminals = GetIndex().terminals;
+    return {terminals.begin(), terminals.end()};
   }
 };
 
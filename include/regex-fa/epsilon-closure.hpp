@@ -0,0 +1,127 @@
+#ifndef REGEX_FA_EPSILON_CLOSURE_HPP
+#define REGEX_FA_EPSILON_CLOSURE_HPP
+
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Epsilon closures of all states 0..n-1, computed once.
+ * Epsilon SCCs are condensed with Tarjan's algorithm, so states of one SCC
+ * share a single closure, and each closure is built from the closures of the
+ * SCCs it reaches.
+ */
+class EpsilonClosure {
+ private:
+  std::vector<uint32_t> component_;      // state -> scc
+  std::vector<uint32_t> closure_first_;  // scc -> range in closures_
+  std::vector<uint32_t> closures_;       // sorted states
+
+ public:
+  EpsilonClosure() = default;
+
+  /**
+   * @param edge_first Epsilon edges of u are edges[edge_first[u],
+   * edge_first[u + 1]), edge_first has n + 1 entries.
+   * @param edges Targets of epsilon edges.
+   */
+  EpsilonClosure(std::span<const uint32_t> edge_first,
+                 std::span<const uint32_t> edges) {
+    const auto n = static_cast<uint32_t>(edge_first.size() - 1);
+    constexpr auto kNone = std::numeric_limits<uint32_t>::max();
+
+    component_.assign(n, kNone);
+    closure_first_.emplace_back(0);
+
+    auto index = std::vector<uint32_t>(n, kNone);
+    auto low_link = std::vector<uint32_t>(n, 0);
+    auto stack = std::vector<uint32_t>{};
+    auto stamp = std::vector<uint32_t>(n, kNone);
+    uint32_t free_index = 0;
+
+    // Iterative Tarjan, call stack of (state, next edge).
+    auto call_stack = std::vector<std::pair<uint32_t, uint32_t>>{};
+    for (uint32_t root = 0; root < n; ++root) {
+      if (index[root] != kNone) {
+        continue;
+      }
+      call_stack.emplace_back(root, edge_first[root]);
+      index[root] = low_link[root] = free_index++;
+      stack.emplace_back(root);
+
+      while (!call_stack.empty()) {
+        auto &[u, next_edge] = call_stack.back();
+        if (next_edge < edge_first[u + 1]) {
+          auto v = edges[next_edge++];
+          if (index[v] == kNone) {
+            index[v] = low_link[v] = free_index++;
+            stack.emplace_back(v);
+            call_stack.emplace_back(v, edge_first[v]);
+          } else if (component_[v] == kNone) {
+            low_link[u] = std::min(low_link[u], index[v]);
+          }
+          continue;
+        }
+
+        auto done = u;
+        call_stack.pop_back();
+        if (!call_stack.empty()) {
+          auto parent = call_stack.back().first;
+          low_link[parent] = std::min(low_link[parent], low_link[done]);
+        }
+        if (low_link[done] != index[done]) {
+          continue;
+        }
+
+        // done is the root of an SCC. SCCs come out in reverse topological
+        // order, so every SCC reachable from this one is already closed.
+        const auto scc = static_cast<uint32_t>(closure_first_.size() - 1);
+        const auto begin = closures_.size();
+        auto members_begin = stack.end();
+        do {
+          --members_begin;
+          component_[*members_begin] = scc;
+        } while (*members_begin != done);
+
+        for (auto it = members_begin; it != stack.end(); ++it) {
+          stamp[*it] = scc;
+          closures_.emplace_back(*it);
+        }
+        for (auto it = members_begin; it != stack.end(); ++it) {
+          for (auto i = edge_first[*it]; i < edge_first[*it + 1]; ++i) {
+            auto other = component_[edges[i]];
+            if (other == scc) {
+              continue;
+            }
+            for (auto j = closure_first_[other]; j < closure_first_[other + 1];
+                 ++j) {
+              auto w = closures_[j];
+              if (stamp[w] != scc) {
+                stamp[w] = scc;
+                closures_.emplace_back(w);
+              }
+            }
+          }
+        }
+        stack.erase(members_begin, stack.end());
+
+        std::sort(closures_.begin() + static_cast<ptrdiff_t>(begin),
+                  closures_.end());
+        closure_first_.emplace_back(static_cast<uint32_t>(closures_.size()));
+      }
+    }
+  }
+
+  /**
+   * Sorted epsilon closure of u, u included.
+   */
+  [[nodiscard]] std::span<const uint32_t> Get(uint32_t u) const {
+    const auto scc = component_[u];
+    return {closures_.data() + closure_first_[scc],
+            closures_.data() + closure_first_[scc + 1]};
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_EPSILON_CLOSURE_HPP
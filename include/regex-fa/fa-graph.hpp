@@ -17,19 +17,20 @@ inline States GetReachable(const FaUnweightedGraph &graph,
                            const States &start) {
   auto res = States{};
 
+  // Mark states when pushed, so each one enters the queue once.
   auto q = std::queue<StateId>{};
   for (const auto &s : start) {
-    q.push(s);
+    if (res.emplace(s).second) {
+      q.push(s);
+    }
   }
 
   while (!q.empty()) {
     auto u = q.front();
     q.pop();
 
-    res.emplace(u);
-
     for (const auto &v : graph.at(u)) {
-      if (!res.contains(v)) {
+      if (res.emplace(v).second) {
         q.push(v);
       }
     }
@@ -37,6 +38,135 @@ inline States GetReachable(const FaUnweightedGraph &graph,
   return res;
 }
 
+/**
+ * Set of dense states 0..n-1, one bit per state.
+ */
+class StateBitset {
+ private:
+  std::vector<uint64_t> words_;
+
+ public:
+  explicit StateBitset(size_t size) : words_((size + 63) / 64) {}
+
+  [[nodiscard]] bool Contains(uint32_t u) const {
+    return (words_[u / 64] >> (u % 64)) & 1;
+  }
+
+  /**
+   * @return Whether u was not in the set.
+   */
+  bool Insert(uint32_t u) {
+    const auto bit = uint64_t{1} << (u % 64);
+    const auto inserted = (words_[u / 64] & bit) == 0;
+    words_[u / 64] |= bit;
+    return inserted;
+  }
+
+  void Intersect(const StateBitset &other) {
+    assert(words_.size() == other.words_.size());
+    for (size_t i = 0; i < words_.size(); ++i) {
+      words_[i] &= other.words_[i];
+    }
+  }
+
+  [[nodiscard]] size_t Count() const {
+    size_t res = 0;
+    for (auto word : words_) {
+      res += std::popcount(word);
+    }
+    return res;
+  }
+};
+
+/**
+ * Unweighted graph over dense states 0..n-1 in compressed sparse row form:
+ * the targets of u are targets_[first_[u], first_[u + 1]). Two flat arrays
+ * instead of a hash map of hash sets, searched with a StateBitset.
+ */
+class CsrFaGraph {
+ public:
+  using Edge = std::pair<uint32_t, uint32_t>;
+
+ private:
+  std::vector<uint32_t> first_;
+  std::vector<uint32_t> targets_;
+
+ public:
+  /**
+   * @param edges u -> v pairs, u and v below state_count. Duplicates are
+   * kept.
+   */
+  CsrFaGraph(size_t state_count, std::span<const Edge> edges)
+      : first_(state_count + 1, 0), targets_(edges.size()) {
+    for (const auto &[u, v] : edges) {
+      ++first_[u + 1];
+    }
+    for (size_t u = 0; u < state_count; ++u) {
+      first_[u + 1] += first_[u];
+    }
+    auto next = std::vector<uint32_t>{first_.begin(), first_.end() - 1};
+    for (const auto &[u, v] : edges) {
+      targets_[next[u]++] = v;
+    }
+  }
+
+  [[nodiscard]] size_t StateCount() const { return first_.size() - 1; }
+  [[nodiscard]] size_t EdgeCount() const { return targets_.size(); }
+
+  [[nodiscard]] std::span<const uint32_t> GetTargets(uint32_t u) const {
+    return {targets_.data() + first_[u], targets_.data() + first_[u + 1]};
+  }
+
+  /**
+   * Same graph with every edge reversed.
+   */
+  [[nodiscard]] CsrFaGraph Reverse() const {
+    auto edges = std::vector<Edge>{};
+    edges.reserve(EdgeCount());
+    for (uint32_t u = 0; u < StateCount(); ++u) {
+      for (auto v : GetTargets(u)) {
+        edges.emplace_back(v, u);
+      }
+    }
+    return {StateCount(), edges};
+  }
+
+  /**
+   * States reachable from start, start included.
+   */
+  [[nodiscard]] StateBitset GetReachable(
+      std::span<const uint32_t> start) const {
+    auto res = StateBitset{StateCount()};
+    auto stack = std::vector<uint32_t>{};
+    for (auto s : start) {
+      if (res.Insert(s)) {
+        stack.emplace_back(s);
+      }
+    }
+    while (!stack.empty()) {
+      const auto u = stack.back();
+      stack.pop_back();
+      for (auto v : GetTargets(u)) {
+        if (res.Insert(v)) {
+          stack.emplace_back(v);
+        }
+      }
+    }
+    return res;
+  }
+
+  /**
+   * States reachable from start that also reach one of finals, the states
+   * an automaton keeps when trimmed.
+   */
+  [[nodiscard]] StateBitset GetUseful(std::span<const uint32_t> start,
+                                      std::span<const uint32_t> finals) const {
+    auto res = GetReachable(start);
+    res.Intersect(Reverse().GetReachable(finals));
+    return res;
+  }
+};
+
 }  // namespace regex_fa
 
 #endif  // REGEX_FA_FA_GRAPH_HPP
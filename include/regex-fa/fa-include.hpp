@@ -2,15 +2,29 @@
 #define REGEX_FA_TEST_FA_INCLUDE_HPP
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <queue>
 #include <ranges>
 #include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace regex_fa {
@@ -24,6 +38,16 @@ using OrderedStates = std::set<StateId>;
 
 using FlatStates = std::vector<StateId>;
 
+/**
+ * Patterns accepted by a final state, sorted and unique. A final state that
+ * is not a key of the AcceptTable accepts kDefaultPatterns.
+ */
+using PatternId = uint32_t;
+using PatternIds = std::vector<PatternId>;
+using AcceptTable = std::unordered_map<StateId, PatternIds>;
+
+inline constexpr std::array<PatternId, 1> kDefaultPatterns{0};
+
 template <typename States>
   requires std::ranges::range<States>
 FlatStates toFlatStates(const States &states) {
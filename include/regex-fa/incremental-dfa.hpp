@@ -0,0 +1,231 @@
+#ifndef REGEX_FA_INCREMENTAL_DFA_HPP
+#define REGEX_FA_INCREMENTAL_DFA_HPP
+
+#include "dfa.hpp"
+#include "fa-include.hpp"
+#include "nfa.hpp"
+#include "regex.hpp"
+#include "subset-table.hpp"
+
+namespace regex_fa {
+
+/**
+ * Minimal multi-pattern Dfa that patterns are added to and removed from one
+ * at a time, without determinizing or minimizing the whole set again.
+ * Every state is the product of one state (or dead) per pattern, each
+ * pattern's Dfa being minimal and trimmed. Such a product is minimal by
+ * itself: the patterns a state accepts along every word tell each component
+ * state apart. So
+ *   Add determinizes and minimizes only the new pattern, then builds the
+ *   product of the current Dfa with it: O(resulting states * terminals).
+ *   Remove drops the pattern's column and merges states whose remaining
+ *   tuples are equal: O(states * patterns), no Nfa or Dfa is rebuilt.
+ * Both still touch every state of the result, so they scale with the size
+ * of the automaton, but not with the cost of ToDfa() and Minimize() over all
+ * patterns. Tuples take states * patterns * 4 bytes.
+ */
+class IncrementalDfa {
+ private:
+  static constexpr uint32_t kDead = std::numeric_limits<uint32_t>::max();
+
+  Dfa dfa_{{{0, {}}}, 0, {}};
+  PatternIds patterns_;  // pattern of each column, ascending
+  SubsetTable tuples_;   // state -> one component state per column
+  PatternId next_pattern_{0};
+
+ public:
+  IncrementalDfa() { tuples_.Insert({}); }
+
+  /**
+   * Combined Dfa, states numbered 0..n-1 with the start state 0. Each state
+   * accepts the patterns of its final components.
+   */
+  [[nodiscard]] const Dfa &GetDfa() const { return dfa_; }
+
+  [[nodiscard]] const PatternIds &GetPatterns() const { return patterns_; }
+
+  /**
+   * Add a pattern accepted by every final state of nfa.
+   * @return Id of the pattern, ids are never reused.
+   */
+  PatternId Add(const Nfa &nfa) {
+    const auto pattern = next_pattern_++;
+    const auto component = Component::FromDfa(nfa.ToDfa().Minimize());
+
+    const auto &dfa_table = dfa_.GetDfaTable();
+    auto tuples = SubsetTable{};
+    auto pairs = std::vector<std::pair<uint32_t, uint32_t>>{};
+    auto tuple = std::vector<uint32_t>{};
+    auto Intern = [&](uint32_t u, uint32_t b) {
+      tuple.clear();
+      if (u == kDead) {
+        tuple.resize(patterns_.size(), kDead);
+      } else {
+        const auto old_tuple = tuples_.Get(u);
+        tuple.assign(old_tuple.begin(), old_tuple.end());
+      }
+      tuple.emplace_back(b);
+      auto [id, inserted] = tuples.Insert(tuple);
+      if (inserted) {
+        pairs.emplace_back(u, b);
+      }
+      return static_cast<StateId>(id);
+    };
+
+    auto new_table = Dfa::DfaTable{};
+    auto f = States{};
+    auto accept = AcceptTable{};
+    Intern(0, component.s);
+    for (StateId i = 0; i < pairs.size(); ++i) {
+      const auto [u, b] = pairs[i];
+      auto &trans_table = new_table[i];
+      if (u != kDead) {
+        for (const auto &[t, v] : dfa_table.at(u)) {
+          trans_table[t] =
+              Intern(static_cast<uint32_t>(v), component.Next(b, t));
+        }
+      }
+      if (b != kDead) {
+        for (const auto &[t, w] : component.table[b]) {
+          if (u == kDead || !dfa_table.at(u).contains(t)) {
+            trans_table[t] = Intern(kDead, w);
+          }
+        }
+      }
+
+      auto patterns = PatternIds{};
+      if (u != kDead) {
+        const auto old_patterns = dfa_.GetPatterns(u);
+        patterns.assign(old_patterns.begin(), old_patterns.end());
+      }
+      if (b != kDead && component.f[b]) {
+        patterns.emplace_back(pattern);
+      }
+      if (!patterns.empty()) {
+        f.emplace(i);
+        accept.emplace(i, std::move(patterns));
+      }
+    }
+
+    patterns_.emplace_back(pattern);
+    tuples_ = std::move(tuples);
+    dfa_ = Dfa{std::move(new_table), 0, std::move(f), std::move(accept)};
+    return pattern;
+  }
+
+  /**
+   * @throw RegexError If pattern is malformed.
+   */
+  PatternId Add(std::string_view pattern) { return Add(RegexToNfa(pattern)); }
+
+  /**
+   * Remove pattern, states told apart only by it merge.
+   * @return Whether pattern was present.
+   */
+  bool Remove(PatternId pattern) {
+    const auto it = std::ranges::find(patterns_, pattern);
+    if (it == patterns_.end()) {
+      return false;
+    }
+    const auto column = static_cast<size_t>(it - patterns_.begin());
+
+    const auto &dfa_table = dfa_.GetDfaTable();
+    const auto n = tuples_.Size();
+    auto tuples = SubsetTable{};
+    auto new_ids = std::vector<uint32_t>(n, kDead);
+    auto representatives = std::vector<uint32_t>{};
+    auto tuple = std::vector<uint32_t>{};
+    for (uint32_t u = 0; u < n; ++u) {
+      const auto old_tuple = tuples_.Get(u);
+      tuple.assign(old_tuple.begin(), old_tuple.end());
+      tuple.erase(tuple.begin() + static_cast<ptrdiff_t>(column));
+      if (u != 0 && std::ranges::all_of(tuple, [](uint32_t b) {
+            return b == kDead;
+          })) {
+        continue;
+      }
+      auto [id, inserted] = tuples.Insert(tuple);
+      new_ids[u] = id;
+      if (inserted) {
+        representatives.emplace_back(u);
+      }
+    }
+
+    auto new_table = Dfa::DfaTable{};
+    auto f = States{};
+    auto accept = AcceptTable{};
+    for (StateId i = 0; i < representatives.size(); ++i) {
+      const auto u = representatives[i];
+      auto &trans_table = new_table[i];
+      for (const auto &[t, v] : dfa_table.at(u)) {
+        if (new_ids[v] != kDead) {
+          trans_table[t] = new_ids[v];
+        }
+      }
+      auto patterns = PatternIds{};
+      for (auto p : dfa_.GetPatterns(u)) {
+        if (p != pattern) {
+          patterns.emplace_back(p);
+        }
+      }
+      if (!patterns.empty()) {
+        f.emplace(i);
+        accept.emplace(i, std::move(patterns));
+      }
+    }
+
+    patterns_.erase(it);
+    tuples_ = std::move(tuples);
+    dfa_ = Dfa{std::move(new_table), 0, std::move(f), std::move(accept)};
+    return true;
+  }
+
+ private:
+  /**
+   * Trimmed Dfa of one pattern, states numbered densely.
+   */
+  struct Component {
+    std::vector<std::unordered_map<Terminal, uint32_t>> table{};
+    std::vector<bool> f{};
+    uint32_t s{kDead};
+
+    [[nodiscard]] uint32_t Next(uint32_t b, const Terminal &t) const {
+      if (b == kDead) {
+        return kDead;
+      }
+      auto it = table[b].find(t);
+      return it == table[b].end() ? kDead : it->second;
+    }
+
+    /**
+     * Dense copy of dfa.Trim(). A start state that accepts nothing is dead.
+     */
+    [[nodiscard]] static Component FromDfa(const Dfa &dfa) {
+      const auto trimmed = dfa.Trim();
+      const auto &dfa_table = trimmed.GetDfaTable();
+
+      auto res = Component{};
+      auto ids = std::unordered_map<StateId, uint32_t>{};
+      for (auto u : toFlatStates(dfa_table | std::views::keys)) {
+        ids.emplace(u, static_cast<uint32_t>(ids.size()));
+      }
+      res.table.resize(ids.size());
+      res.f.resize(ids.size());
+      for (const auto &[u, id] : ids) {
+        res.f[id] = trimmed.GetF().contains(u);
+        for (const auto &[t, v] : dfa_table.at(u)) {
+          res.table[id].emplace(t, ids.at(v));
+        }
+      }
+      const auto s = ids.at(trimmed.GetS());
+      if (res.f[s] || !res.table[s].empty()) {
+        res.s = s;
+      }
+      return res;
+    }
+  };
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_INCREMENTAL_DFA_HPP
@@ -0,0 +1,230 @@
+#ifndef REGEX_FA_LAZY_DFA_HPP
+#define REGEX_FA_LAZY_DFA_HPP
+
+#include "dense-nfa.hpp"
+#include "fa-include.hpp"
+#include "nfa.hpp"
+#include "subset-table.hpp"
+
+namespace regex_fa {
+
+/**
+ * Dfa of an Nfa built on demand while matching.
+ * Subset states and transitions are only made when input reaches them, and
+ * kept in a cache of at most Options::maxStates states. A full cache is
+ * flushed. If flushes come faster than Options::minBytesPerState input bytes
+ * per cached state, the rest of the input is matched by plain Nfa
+ * simulation instead.
+ * Matching works on bytes like DenseDfa. A LazyDfa mutates its cache while
+ * matching, so it must not be shared between threads.
+ */
+class LazyDfa {
+ public:
+  struct Options {
+    size_t maxStates = 4096;
+    size_t minBytesPerState = 10;
+  };
+
+ private:
+  using CacheStateId = SubsetTable::SubsetId;
+
+  static constexpr CacheStateId kUnknown =
+      std::numeric_limits<CacheStateId>::max();
+  static constexpr CacheStateId kDead = kUnknown - 1;
+
+  DenseNfa nfa_;
+  Options options_;
+  std::array<SymbolId, 256> byte_symbols_{};
+
+  SubsetTable cache_;
+  std::vector<CacheStateId> table_;  // table_[u * stride + t] = v
+  std::vector<uint8_t> accepting_;
+  size_t flush_count_{0};
+  size_t fallback_count_{0};
+
+  // Scratch for Step.
+  std::vector<uint32_t> next_subset_;
+  std::vector<uint32_t> other_subset_;
+  std::vector<uint32_t> stamp_;
+  uint32_t cur_stamp_{0};
+
+ public:
+  explicit LazyDfa(const Nfa &nfa) : LazyDfa(nfa, Options{}) {}
+
+  LazyDfa(const Nfa &nfa, Options options)
+      : nfa_(nfa.GetDenseNfa()), options_(options) {
+    assert(options_.maxStates > 0);
+    byte_symbols_.fill(SymbolTable::kNoSymbol);
+    for (SymbolId t = 0; t < nfa_.symbols.Size(); ++t) {
+      if (const auto &terminal = nfa_.symbols.GetTerminal(t);
+          terminal.size() == 1) {
+        byte_symbols_[static_cast<uint8_t>(terminal[0])] = t;
+      }
+    }
+    stamp_.assign(nfa_.Size(), 0);
+  }
+
+  [[nodiscard]] size_t GetCacheSize() const { return cache_.Size(); }
+  [[nodiscard]] size_t GetFlushCount() const { return flush_count_; }
+
+  /**
+   * Number of calls that fell back to Nfa simulation.
+   */
+  [[nodiscard]] size_t GetFallbackCount() const { return fallback_count_; }
+
+  [[nodiscard]] bool Accepts(std::span<const std::byte> input) {
+    auto res = false;
+    Run(input, [&res, size = input.size()](size_t pos, bool accepting) {
+      res = pos == size && accepting;
+      return true;
+    });
+    return res;
+  }
+
+  [[nodiscard]] bool Accepts(std::string_view input) {
+    return Accepts(std::as_bytes(std::span{input.data(), input.size()}));
+  }
+
+  /**
+   * Longest accepted prefix of input, like DenseDfa::LongestMatch.
+   */
+  [[nodiscard]] std::optional<size_t> LongestMatch(
+      std::span<const std::byte> input) {
+    auto res = std::optional<size_t>{};
+    Run(input, [&res](size_t pos, bool accepting) {
+      if (accepting) {
+        res = pos;
+      }
+      return true;
+    });
+    return res;
+  }
+
+  [[nodiscard]] std::optional<size_t> LongestMatch(std::string_view input) {
+    return LongestMatch(std::as_bytes(std::span{input.data(), input.size()}));
+  }
+
+ private:
+  [[nodiscard]] size_t Stride() const { return nfa_.symbols.Size(); }
+
+  /**
+   * Run over input until it ends or no state is left.
+   * @param on_state Called as on_state(pos, accepting) after reading
+   * input[0, pos), starting from pos 0.
+   */
+  template <typename OnState>
+  void Run(std::span<const std::byte> input, OnState &&on_state) {
+    next_subset_.assign(nfa_.closure.Get(nfa_.s).begin(),
+                        nfa_.closure.Get(nfa_.s).end());
+    auto u = AddState(next_subset_);
+    on_state(0, accepting_[u]);
+
+    size_t bytes_since_flush = 0;
+    for (size_t i = 0; i < input.size(); ++i, ++bytes_since_flush) {
+      const auto t = byte_symbols_[std::to_integer<uint8_t>(input[i])];
+      if (t == SymbolTable::kNoSymbol) {
+        return;
+      }
+
+      auto v = table_[u * Stride() + t];
+      if (v == kUnknown) {
+        Step(cache_.Get(u), t, next_subset_);
+        if (next_subset_.empty()) {
+          v = table_[u * Stride() + t] = kDead;
+        } else if (auto found = cache_.Find(next_subset_); found.has_value()) {
+          v = table_[u * Stride() + t] = found.value();
+        } else if (cache_.Size() < options_.maxStates) {
+          v = AddState(next_subset_);
+          table_[u * Stride() + t] = v;
+        } else if (bytes_since_flush <
+                   options_.minBytesPerState * cache_.Size()) {
+          // The cache is thrashing, stop caching.
+          ++fallback_count_;
+          Simulate(input.subspan(i + 1), i + 1, on_state);
+          return;
+        } else {
+          Flush();
+          bytes_since_flush = 0;
+          v = AddState(next_subset_);
+        }
+      }
+
+      if (v == kDead) {
+        return;
+      }
+      u = v;
+      on_state(i + 1, accepting_[u]);
+    }
+  }
+
+  /**
+   * Nfa simulation from next_subset_, which was reached at pos.
+   */
+  template <typename OnState>
+  void Simulate(std::span<const std::byte> input, size_t pos,
+                OnState &&on_state) {
+    on_state(pos, nfa_.HasFinal(next_subset_));
+    for (auto byte : input) {
+      const auto t = byte_symbols_[std::to_integer<uint8_t>(byte)];
+      if (t == SymbolTable::kNoSymbol) {
+        return;
+      }
+      std::swap(next_subset_, other_subset_);
+      Step(other_subset_, t, next_subset_);
+      if (next_subset_.empty()) {
+        return;
+      }
+      on_state(++pos, nfa_.HasFinal(next_subset_));
+    }
+  }
+
+  /**
+   * Find or add a cache state for subset. The cache must not be full unless
+   * subset is already in it.
+   */
+  CacheStateId AddState(std::span<const uint32_t> subset) {
+    if (auto found = cache_.Find(subset); found.has_value()) {
+      return found.value();
+    }
+    if (cache_.Size() >= options_.maxStates) {
+      Flush();
+    }
+    auto [id, inserted] = cache_.Insert(subset);
+    table_.resize(cache_.Size() * Stride(), kUnknown);
+    accepting_.emplace_back(nfa_.HasFinal(subset));
+    return id;
+  }
+
+  void Flush() {
+    ++flush_count_;
+    cache_.Clear();
+    table_.clear();
+    accepting_.clear();
+  }
+
+  /**
+   * Subset reached from subset by terminal t, with epsilon closure.
+   */
+  void Step(std::span<const uint32_t> subset, SymbolId t,
+            std::vector<uint32_t> &res) {
+    ++cur_stamp_;
+    res.clear();
+    for (auto u : subset) {
+      const auto edges = nfa_.GetEdges(u);
+      for (auto it = std::ranges::lower_bound(edges, DenseNfa::Edge{t, 0});
+           it != edges.end() && it->symbol == t; ++it) {
+        for (auto w : nfa_.closure.Get(it->target)) {
+          if (stamp_[w] != cur_stamp_) {
+            stamp_[w] = cur_stamp_;
+            res.emplace_back(w);
+          }
+        }
+      }
+    }
+    std::ranges::sort(res);
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_LAZY_DFA_HPP
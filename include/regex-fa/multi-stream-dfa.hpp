@@ -0,0 +1,336 @@
+#ifndef REGEX_FA_MULTI_STREAM_DFA_HPP
+#define REGEX_FA_MULTI_STREAM_DFA_HPP
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define REGEX_FA_HAS_X86_SIMD
+#endif
+
+#include "dense-dfa-view.hpp"
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * DenseDfa prepared for matching many independent inputs, such as short
+ * records, at high throughput.
+ * A plain Dfa walk is bound by the latency of each transition load, which
+ * depends on the previous one. Two kernels break that chain:
+ *   kInterleaved runs several inputs at once, one state chain per lane, so
+ *   their loads overlap. Transitions are premultiplied and the dead state is
+ *   a real row, so a step is a single load with no branch.
+ *   kSsse3 and kAvx2 work on Dfas with at most 16 states, dead state
+ *   included (minimize first). They keep the state reached from every state
+ *   in a 16-byte vector and compose it with the next byte's transitions by
+ *   PSHUFB, whose latency is one cycle. kAvx2 runs two inputs per vector.
+ * Shuffle kernels need x86 and are picked at run time by CPU support.
+ */
+class MultiStreamDfa {
+ public:
+  enum class Kernel : uint8_t {
+    kAuto,         // best supported kernel
+    kInterleaved,  // portable
+    kSsse3,
+    kAvx2,
+  };
+
+  static constexpr size_t kMaxShuffleStates = 16;
+
+ private:
+  using ShuffleTable = std::array<uint8_t, kMaxShuffleStates>;
+
+  static constexpr size_t kRound = 64;  // bytes between checks for dead lanes
+
+  size_t class_count_{0};
+  std::vector<uint32_t> table_;  // table_[s + c], s = u * class_count_
+  uint32_t dead_{0};             // premultiplied dead row
+  std::array<ClassId, 256> byte_classes_{};
+  std::vector<uint8_t> accepting_;  // by dense state, dead state last
+
+  // Shuffle kernels: shuffle_[c][u] = v, dead state is shuffle_dead_.
+  std::vector<ShuffleTable> shuffle_;
+  uint8_t shuffle_dead_{0};
+  Kernel kernel_{Kernel::kInterleaved};
+
+ public:
+  /**
+   * @param kernel Kernel to use. Falls back to kInterleaved if it is not
+   * supported by the CPU or the Dfa is too large for it.
+   */
+  explicit MultiStreamDfa(const DenseDfaView &dfa,
+                          Kernel kernel = Kernel::kAuto)
+      : class_count_(dfa.ClassCount()) {
+    assert(class_count_ > 0);
+    const auto state_count = dfa.StateCount();
+    dead_ = static_cast<uint32_t>(state_count * class_count_);
+    table_.resize((state_count + 1) * class_count_, dead_);
+    for (DenseDfaView::DenseStateId u = 0; u < state_count; ++u) {
+      for (ClassId c = 0; c < class_count_; ++c) {
+        if (auto v = dfa.NextByClass(u, c); v != DenseDfaView::kDeadState) {
+          table_[u * class_count_ + c] =
+              static_cast<uint32_t>(v * class_count_);
+        }
+      }
+    }
+    for (unsigned b = 0; b < 256; ++b) {
+      byte_classes_[b] = dfa.GetClass(static_cast<std::byte>(b));
+    }
+    for (DenseDfaView::DenseStateId u = 0; u < state_count; ++u) {
+      accepting_.emplace_back(dfa.IsAccepting(u));
+    }
+    accepting_.emplace_back(0);
+
+    if (state_count + 1 <= kMaxShuffleStates) {
+      shuffle_dead_ = static_cast<uint8_t>(state_count);
+      shuffle_.resize(class_count_);
+      for (ClassId c = 0; c < class_count_; ++c) {
+        shuffle_[c].fill(shuffle_dead_);
+        for (DenseDfaView::DenseStateId u = 0; u < state_count; ++u) {
+          if (auto v = dfa.NextByClass(u, c); v != DenseDfaView::kDeadState) {
+            shuffle_[c][u] = static_cast<uint8_t>(v);
+          }
+        }
+      }
+    }
+
+    if (kernel == Kernel::kAuto) {
+      kernel = IsSupported(Kernel::kAvx2) ? Kernel::kAvx2 : Kernel::kSsse3;
+    }
+    kernel_ = IsSupported(kernel) && !shuffle_.empty() ? kernel
+                                                       : Kernel::kInterleaved;
+  }
+
+  /**
+   * Whether the CPU supports kernel.
+   */
+  [[nodiscard]] static bool IsSupported(Kernel kernel) {
+    switch (kernel) {
+      case Kernel::kAuto:
+      case Kernel::kInterleaved:
+        return true;
+#ifdef REGEX_FA_HAS_X86_SIMD
+      case Kernel::kSsse3:
+        return __builtin_cpu_supports("ssse3");
+      case Kernel::kAvx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+      default:
+        return false;
+    }
+  }
+
+  [[nodiscard]] Kernel GetKernel() const { return kernel_; }
+
+  /**
+   * Full match of every input, results[i] is whether inputs[i] is accepted.
+   */
+  void Accepts(std::span<const std::span<const std::byte>> inputs,
+               std::span<uint8_t> results) const {
+    AcceptsImpl(inputs, results);
+  }
+
+  void Accepts(std::span<const std::string_view> inputs,
+               std::span<uint8_t> results) const {
+    AcceptsImpl(inputs, results);
+  }
+
+  [[nodiscard]] std::vector<uint8_t> Accepts(
+      std::span<const std::string_view> inputs) const {
+    auto res = std::vector<uint8_t>(inputs.size());
+    Accepts(inputs, res);
+    return res;
+  }
+
+  /**
+   * Full match of every input by kLanes interleaved state chains, whatever
+   * the kernel.
+   */
+  template <size_t kLanes, typename Input>
+  void AcceptsInterleaved(std::span<const Input> inputs,
+                          std::span<uint8_t> results) const {
+    static_assert(kLanes >= 1 && kLanes <= 16);
+    assert(results.size() == inputs.size());
+
+    std::array<const uint8_t *, kLanes> pos{};
+    std::array<size_t, kLanes> left{};
+    std::array<uint32_t, kLanes> states{};
+    std::array<size_t, kLanes> index{};
+    size_t next_input = 0;
+
+    // Load the next non-empty input into lane i.
+    auto Refill = [&](size_t i) {
+      for (; next_input < inputs.size(); ++next_input) {
+        const auto bytes = AsBytes(inputs[next_input]);
+        if (bytes.empty()) {
+          results[next_input] = accepting_[0];
+          continue;
+        }
+        pos[i] = reinterpret_cast<const uint8_t *>(bytes.data());
+        left[i] = bytes.size();
+        states[i] = 0;
+        index[i] = next_input++;
+        return true;
+      }
+      return false;
+    };
+
+    size_t active = 0;
+    while (active < kLanes && Refill(active)) {
+      ++active;
+    }
+
+    while (active == kLanes) {
+      auto round = kRound;
+      for (size_t i = 0; i < kLanes; ++i) {
+        round = std::min(round, left[i]);
+      }
+      for (size_t k = 0; k < round; ++k) {
+        for (size_t i = 0; i < kLanes; ++i) {
+          states[i] = table_[states[i] + byte_classes_[pos[i][k]]];
+        }
+      }
+
+      for (size_t i = 0; i < kLanes; ++i) {
+        pos[i] += round;
+        left[i] -= round;
+        if (left[i] == 0 || states[i] == dead_) {
+          results[index[i]] = left[i] == 0 && IsAccepting(states[i]);
+          if (!Refill(i)) {
+            left[i] = 0;
+            --active;
+          }
+        }
+      }
+    }
+
+    // Fewer inputs than lanes left, finish them one by one. Empty lanes have
+    // nothing left.
+    for (size_t i = 0; i < kLanes; ++i) {
+      if (left[i] != 0) {
+        results[index[i]] = AcceptsFrom(states[i], {pos[i], left[i]});
+      }
+    }
+  }
+
+ private:
+  [[nodiscard]] static std::span<const std::byte> AsBytes(
+      std::string_view input) {
+    return DenseDfaView::AsBytes(input);
+  }
+
+  [[nodiscard]] static std::span<const std::byte> AsBytes(
+      std::span<const std::byte> input) {
+    return input;
+  }
+
+  [[nodiscard]] bool IsAccepting(uint32_t s) const {
+    return accepting_[s / class_count_];
+  }
+
+  [[nodiscard]] bool AcceptsFrom(uint32_t s,
+                                 std::span<const uint8_t> input) const {
+    for (auto byte : input) {
+      s = table_[s + byte_classes_[byte]];
+    }
+    return IsAccepting(s);
+  }
+
+  template <typename Input>
+  void AcceptsImpl(std::span<const Input> inputs,
+                   std::span<uint8_t> results) const {
+    assert(results.size() == inputs.size());
+    switch (kernel_) {
+#ifdef REGEX_FA_HAS_X86_SIMD
+      case Kernel::kSsse3:
+        for (size_t i = 0; i < inputs.size(); ++i) {
+          results[i] = IsShuffleAccepting(ShuffleSsse3(0, AsBytes(inputs[i])));
+        }
+        return;
+      case Kernel::kAvx2: {
+        size_t i = 0;
+        for (; i + 1 < inputs.size(); i += 2) {
+          auto [first, second] =
+              ShuffleAvx2(AsBytes(inputs[i]), AsBytes(inputs[i + 1]));
+          results[i] = IsShuffleAccepting(first);
+          results[i + 1] = IsShuffleAccepting(second);
+        }
+        if (i < inputs.size()) {
+          results[i] = IsShuffleAccepting(ShuffleSsse3(0, AsBytes(inputs[i])));
+        }
+        return;
+      }
+#endif
+      default:
+        AcceptsInterleaved<8>(inputs, results);
+        return;
+    }
+  }
+
+  [[nodiscard]] bool IsShuffleAccepting(uint8_t u) const {
+    return accepting_[u];
+  }
+
+#ifdef REGEX_FA_HAS_X86_SIMD
+  /**
+   * State reached from u over input. maps[q] is the state reached from q so
+   * far, each byte composes it with that byte's transitions.
+   */
+  [[nodiscard]] __attribute__((target("ssse3"))) uint8_t ShuffleSsse3(
+      uint8_t u, std::span<const std::byte> input) const {
+    auto maps = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                              14, 15);
+    for (size_t i = 0; i < input.size(); i += kRound) {
+      const auto end = std::min(input.size(), i + kRound);
+      for (auto k = i; k < end; ++k) {
+        const auto *table =
+            shuffle_[byte_classes_[std::to_integer<uint8_t>(input[k])]].data();
+        maps = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(table)), maps);
+      }
+      if (MapOf(maps, u) == shuffle_dead_) {
+        break;
+      }
+    }
+    return MapOf(maps, u);
+  }
+
+  /**
+   * ShuffleSsse3 from state 0 over two inputs at once, one per 128-bit lane.
+   */
+  [[nodiscard]] __attribute__((target("avx2"))) std::pair<uint8_t, uint8_t>
+  ShuffleAvx2(std::span<const std::byte> first,
+              std::span<const std::byte> second) const {
+    const auto identity = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                        12, 13, 14, 15);
+    auto maps = _mm256_set_m128i(identity, identity);
+    const auto size = std::min(first.size(), second.size());
+    for (size_t k = 0; k < size; ++k) {
+      const auto *low =
+          shuffle_[byte_classes_[std::to_integer<uint8_t>(first[k])]].data();
+      const auto *high =
+          shuffle_[byte_classes_[std::to_integer<uint8_t>(second[k])]].data();
+      const auto tables = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(
+              _mm_loadu_si128(reinterpret_cast<const __m128i *>(low))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(high)), 1);
+      maps = _mm256_shuffle_epi8(tables, maps);
+    }
+
+    // Finish the longer input alone.
+    const auto u = MapOf(_mm256_castsi256_si128(maps), 0);
+    const auto v = MapOf(_mm256_extracti128_si256(maps, 1), 0);
+    return {ShuffleSsse3(u, first.subspan(size)),
+            ShuffleSsse3(v, second.subspan(size))};
+  }
+
+  [[nodiscard]] static uint8_t MapOf(__m128i maps, uint8_t u) {
+    alignas(16) std::array<uint8_t, 16> bytes{};
+    _mm_store_si128(reinterpret_cast<__m128i *>(bytes.data()), maps);
+    return bytes[u];
+  }
+#endif
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_MULTI_STREAM_DFA_HPP
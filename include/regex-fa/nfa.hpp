@@ -1,13 +1,23 @@
 #ifndef REGEX_FA_NFA_HPP
 #define REGEX_FA_NFA_HPP
 
+#include "dense-nfa.hpp"
 #include "dfa.hpp"
+#include "fa-graph.hpp"
 #include "fa-include.hpp"
+#include "stats.hpp"
+#include "subset-table.hpp"
+#include "thread-pool.hpp"
 
 namespace regex_fa {
 
 using FlatNfa = FlatDfa;
 
+/**
+ * Terminal of epsilon edges.
+ */
+inline const Terminal kEpsilon{};
+
 struct ScEdge {
   FlatStates source{};
   Terminal terminal{};
@@ -28,50 +38,73 @@ struct ScLog {
   std::vector<ScStep> steps{};
 };
 
-class NfaLogger {
+/**
+ * Receives the steps of Nfa::ToDfa(ScSink &) as they happen, one ScStep per
+ * subset, so nothing accumulates unless the sink keeps it. Each subset
+ * construction has its own sink, so those on several threads trace
+ * independently.
+ */
+class ScSink {
+ public:
+  virtual ~ScSink() = default;
+
+  virtual void OnSource([[maybe_unused]] const FlatNfa &source) {}
+  virtual void OnStep([[maybe_unused]] ScStep step) {}
+  virtual void OnTarget([[maybe_unused]] const FlatDfa &target) {}
+};
+
+/**
+ * ScSink that collects one subset construction into a ScLog.
+ */
+class NfaLogger : public ScSink {
  public:
   ScLog sc_log{};
 
-  static NfaLogger &GetInstance() {
-    static NfaLogger nfa_logger{};
-    return nfa_logger;
+  void OnSource(const FlatNfa &source) override {
+    sc_log = {};
+    sc_log.source = source;
   }
 
- private:
-  NfaLogger() = default;
-
- public:
-  NfaLogger(const NfaLogger &) = delete;
-  NfaLogger(const NfaLogger &&) = delete;
-  NfaLogger &operator=(const NfaLogger &) = delete;
+  void OnStep(ScStep step) override {
+    sc_log.steps.emplace_back(std::move(step));
+  }
 
-  void ClearLog() { sc_log.steps.clear(); }
+  void OnTarget(const FlatDfa &target) override { sc_log.target = target; }
 };
 
 class Nfa {
  public:
   /**
    * NfaTable = map<u, map<t, set<v> > >.
+   * Terminal kEpsilon marks epsilon edges.
    * Warning! For all u --t-> {v}, v must be NfaTable's key.
    */
   using TransTable = std::unordered_map<Terminal, OrderedStates>;
   using NfaTable = std::unordered_map<StateId, TransTable>;
 
  private:
+  struct DenseCache {
+    std::once_flag once;
+    DenseNfa nfa;
+  };
+
   NfaTable nfa_table_;
   StateId s_;
   States f_;
-
-#ifdef REGEX_FA_LOGGER
-  NfaLogger &logger = NfaLogger::GetInstance();
-#endif
+  AcceptTable accept_;
+  // Built on first use. An Nfa never changes its states or transitions, so
+  // copies share it.
+  std::shared_ptr<DenseCache> dense_cache_ = std::make_shared<DenseCache>();
 
  public:
-  Nfa(NfaTable nfa_table, const StateId s, States f)
-      : nfa_table_(std::move(nfa_table)), s_(s), f_(std::move(f)) {}
+  Nfa(NfaTable nfa_table, const StateId s, States f, AcceptTable accept = {})
+      : nfa_table_(std::move(nfa_table)),
+        s_(s),
+        f_(std::move(f)),
+        accept_(std::move(accept)) {}
 
   explicit Nfa(const FlatNfa &flat_nfa)
-      : s_(flat_nfa.s), f_(flat_nfa.f.begin(), flat_nfa.f.cbegin()) {
+      : s_(flat_nfa.s), f_(flat_nfa.f.begin(), flat_nfa.f.end()) {
     for (auto state : flat_nfa.states) {
       nfa_table_[state] = {};
     }
@@ -80,6 +113,129 @@ class Nfa {
     }
   }
 
+  [[nodiscard]] const NfaTable &GetNfaTable() const { return nfa_table_; }
+  [[nodiscard]] StateId GetS() const { return s_; }
+  [[nodiscard]] const States &GetF() const { return f_; }
+  [[nodiscard]] const AcceptTable &GetAcceptTable() const { return accept_; }
+
+  /**
+   * Patterns accepted by state_id, empty if it is not final.
+   */
+  [[nodiscard]] std::span<const PatternId> GetPatterns(StateId state_id) const {
+    if (!f_.contains(state_id)) {
+      return {};
+    }
+    if (auto it = accept_.find(state_id); it != accept_.end()) {
+      return it->second;
+    }
+    return kDefaultPatterns;
+  }
+
+  /**
+   * Union of nfas, nfas[i] accepting pattern i. States are renumbered, the
+   * new start state goes to every old one by epsilon edges.
+   */
+  [[nodiscard]] static Nfa Union(std::span<const Nfa> nfas) {
+    auto nfa_table = NfaTable{};
+    auto f = States{};
+    auto accept = AcceptTable{};
+    const StateId s = 0;
+    auto &s_trans_table = nfa_table[s];
+
+    StateId free_id = 1;
+    for (PatternId pattern = 0; pattern < nfas.size(); ++pattern) {
+      const auto &nfa = nfas[pattern];
+      auto new_ids = std::unordered_map<StateId, StateId>{};
+      for (auto state_id : toFlatStates(nfa.nfa_table_ | std::views::keys)) {
+        new_ids.emplace(state_id, free_id++);
+      }
+      for (const auto &[u, trans_table] : nfa.nfa_table_) {
+        auto &new_trans_table = nfa_table[new_ids.at(u)];
+        for (const auto &[t, targets] : trans_table) {
+          auto &new_targets = new_trans_table[t];
+          for (auto v : targets) {
+            new_targets.emplace(new_ids.at(v));
+          }
+        }
+      }
+      s_trans_table[kEpsilon].emplace(new_ids.at(nfa.s_));
+      for (auto state_id : nfa.f_) {
+        if (auto it = new_ids.find(state_id); it != new_ids.end()) {
+          f.emplace(it->second);
+          accept.emplace(it->second, PatternIds{pattern});
+        }
+      }
+    }
+    return {std::move(nfa_table), s, std::move(f), std::move(accept)};
+  }
+
+  /**
+   * Drop states that are not reachable from s or reach no final state, and
+   * the edges into them; epsilon edges count as edges. s is always kept,
+   * state ids are unchanged. Shrinks the input of ToDfa().
+   */
+  [[nodiscard]] Nfa Trim() const {
+    auto states = FlatStates{s_};
+    states.insert(states.end(), f_.begin(), f_.end());
+    for (const auto &[u, trans_table] : nfa_table_) {
+      states.emplace_back(u);
+      for (const auto &targets : trans_table | std::views::values) {
+        states.insert(states.end(), targets.begin(), targets.end());
+      }
+    }
+    std::ranges::sort(states);
+    states.erase(std::ranges::unique(states).begin(), states.end());
+    auto index = std::unordered_map<StateId, uint32_t>{};
+    for (uint32_t i = 0; i < states.size(); ++i) {
+      index.emplace(states[i], i);
+    }
+
+    auto edges = std::vector<CsrFaGraph::Edge>{};
+    for (const auto &[u, trans_table] : nfa_table_) {
+      for (const auto &targets : trans_table | std::views::values) {
+        for (auto v : targets) {
+          edges.emplace_back(index.at(u), index.at(v));
+        }
+      }
+    }
+    auto finals = std::vector<uint32_t>{};
+    for (auto state_id : f_) {
+      finals.emplace_back(index.at(state_id));
+    }
+    const auto s = std::array{index.at(s_)};
+    const auto useful = CsrFaGraph{states.size(), edges}.GetUseful(s, finals);
+
+    auto nfa_table = NfaTable{{s_, {}}};
+    for (const auto &[u, trans_table] : nfa_table_) {
+      if (!useful.Contains(index.at(u))) {
+        continue;
+      }
+      auto &new_trans_table = nfa_table[u];
+      for (const auto &[t, targets] : trans_table) {
+        auto new_targets = OrderedStates{};
+        for (auto v : targets) {
+          if (useful.Contains(index.at(v))) {
+            new_targets.emplace(v);
+          }
+        }
+        if (!new_targets.empty()) {
+          new_trans_table.emplace(t, std::move(new_targets));
+        }
+      }
+    }
+    auto f = States{};
+    auto accept = AcceptTable{};
+    for (auto state_id : f_) {
+      if (useful.Contains(index.at(state_id))) {
+        f.emplace(state_id);
+        if (auto it = accept_.find(state_id); it != accept_.end()) {
+          accept.emplace(*it);
+        }
+      }
+    }
+    return {std::move(nfa_table), s_, std::move(f), std::move(accept)};
+  }
+
   [[nodiscard]] FlatNfa ToFlatNfa() const {
     auto flatNfa = FlatNfa{};
     flatNfa.s = s_;
@@ -96,91 +252,311 @@ class Nfa {
     }
     return flatNfa;
   }
-  [[nodiscard]] Dfa ToDfa() const {
-#ifdef REGEX_FA_LOGGER
-    logger.ClearLog();
-    logger.sc_log.source = ToFlatNfa();
-#endif
-
-    // subset -> {terminal, states}
-    auto subset_table = std::map<OrderedStates, TransTable>{};
-    auto q = std::queue<OrderedStates>{};
-    q.push({s_});
-    subset_table.try_emplace({s_});
-
-    while (!q.empty()) {
-      auto &[cur_subset, cur_trans_table] = *subset_table.find(q.front());
-      q.pop();
-
-      for (const auto state : cur_subset) {
-        assert(nfa_table_.contains(state));
-        for (auto &[terminal, states] : nfa_table_.at(state)) {
-          cur_trans_table[terminal].insert(states.begin(), states.end());
+
+  /**
+   * Terminals with the same targets from every state, grouped into classes.
+   * kEpsilon is not a terminal here.
+   */
+  [[nodiscard]] TerminalClasses GetTerminalClasses() const {
+    const auto &dense_nfa = GetDenseNfa();
+    auto classes = SymbolClasses{dense_nfa.symbols.Size()};
+    auto edges = std::vector<SymbolClasses::Edge>{};
+    for (uint32_t u = 0; u < dense_nfa.Size(); ++u) {
+      edges.clear();
+      for (const auto &[t, v] : dense_nfa.GetEdges(u)) {
+        edges.emplace_back(v, t);
+      }
+      classes.Refine(edges);
+    }
+    return classes.GetTerminalClasses(dense_nfa.symbols);
+  }
+
+  /**
+   * ToDenseNfa(), built once on first use and shared by copies of this Nfa.
+   * Safe to call from several threads.
+   */
+  [[nodiscard]] const DenseNfa &GetDenseNfa() const {
+    std::call_once(dense_cache_->once,
+                   [this] { dense_cache_->nfa = ToDenseNfa(); });
+    return dense_cache_->nfa;
+  }
+
+  /**
+   * Contiguous states, interned terminals and epsilon closures.
+   */
+  [[nodiscard]] DenseNfa ToDenseNfa() const {
+    auto res = DenseNfa{};
+    res.states = toFlatStates(nfa_table_ | std::views::keys);
+    auto Index = [&res](StateId state_id) {
+      return static_cast<uint32_t>(
+          std::ranges::lower_bound(res.states, state_id) - res.states.begin());
+    };
+
+    auto terminals = Terminals{};
+    for (const auto &trans_table : nfa_table_ | std::views::values) {
+      for (const auto &terminal : trans_table | std::views::keys) {
+        if (terminal != kEpsilon) {
+          terminals.emplace(terminal);
         }
       }
-#ifdef REGEX_FA_LOGGER
-      auto step = ScStep{};
-      step.curSubset.insert(step.curSubset.end(), cur_subset.begin(),
-                            cur_subset.end());
-      if (!logger.sc_log.steps.empty() &&
-          !logger.sc_log.steps.back().waitList.empty()) {
-        step.waitList.insert(step.waitList.end(),
-                             logger.sc_log.steps.back().waitList.begin() + 1,
-                             logger.sc_log.steps.back().waitList.end());
-      }
-      for (auto &[terminal, states] : cur_trans_table) {
-        step.scEdges.emplace_back(toFlatStates(cur_subset), terminal,
-                                  toFlatStates(states));
-      }
-      logger.sc_log.steps.emplace_back(std::move(step));
-#endif
-      for (const auto &states : cur_trans_table | std::views::values) {
-        if (!subset_table.contains(states)) {
-          q.push(states);
-          subset_table.try_emplace(states);
-#ifdef REGEX_FA_LOGGER
-          auto &logger = NfaLogger::GetInstance();
-          logger.sc_log.steps.back().newSubsets.emplace_back(
-              toFlatStates(states));
-          logger.sc_log.steps.back().waitList.emplace_back(
-              toFlatStates(states));
-#endif
+    }
+    res.symbols = SymbolTable{terminals};
+
+    auto epsilon_first = std::vector<uint32_t>{0};
+    auto epsilon_edges = std::vector<uint32_t>{};
+    res.edgeFirst.emplace_back(0);
+    for (auto state_id : res.states) {
+      for (const auto &[terminal, states] : nfa_table_.at(state_id)) {
+        for (auto v : states) {
+          if (terminal == kEpsilon) {
+            epsilon_edges.emplace_back(Index(v));
+          } else {
+            res.edges.emplace_back(res.symbols.Find(terminal), Index(v));
+          }
         }
       }
+      std::sort(res.edges.begin() + res.edgeFirst.back(), res.edges.end());
+      res.edgeFirst.emplace_back(static_cast<uint32_t>(res.edges.size()));
+      epsilon_first.emplace_back(static_cast<uint32_t>(epsilon_edges.size()));
     }
+    res.closure = EpsilonClosure{epsilon_first, epsilon_edges};
 
-    // subset states -> new id
-    auto new_ids = std::map<OrderedStates, StateId>{};
-    StateId free_id = 0;
-    for (const auto &states : subset_table | std::views::keys) {
-      new_ids[states] = free_id++;
+    res.isFinal.assign(res.states.size(), 0);
+    res.patterns.resize(res.states.size());
+    for (auto state_id : f_) {
+      if (nfa_table_.contains(state_id)) {
+        res.isFinal[Index(state_id)] = 1;
+        const auto patterns = GetPatterns(state_id);
+        res.patterns[Index(state_id)].assign(patterns.begin(), patterns.end());
+      }
     }
+    assert(nfa_table_.contains(s_));
+    res.s = Index(s_);
+    return res;
+  }
+
+  /**
+   * Subset construction. Subsets are sorted lists of dense states interned
+   * in a SubsetTable, and each gets its Dfa StateId when first discovered, so
+   * Dfa states are numbered in bfs order. A final subset accepts the
+   * patterns of all its final states.
+   */
+  [[nodiscard]] Dfa ToDfa() const {
+    return ToDfa(*std::pmr::get_default_resource());
+  }
+
+  /**
+   * Same as ToDfa(), with the subset table and the scratch of every step
+   * taken from resource, which is where nearly all allocations happen. A
+   * std::pmr::monotonic_buffer_resource then releases them in one step.
+   */
+  [[nodiscard]] Dfa ToDfa(std::pmr::memory_resource &resource) const {
+    return SubsetConstruction(resource, nullptr);
+  }
+
+  /**
+   * Same as ToDfa(), reporting every step to sink as it happens.
+   */
+  [[nodiscard]] Dfa ToDfa(ScSink &sink) const {
+    return SubsetConstruction(*std::pmr::get_default_resource(), &sink);
+  }
+
+  /**
+   * Subset construction on thread_count threads (0 means one per core).
+   * The frontier of each bfs level is expanded in parallel on a work stealing
+   * ThreadPool, and new subsets are interned in a ConcurrentSubsetTable.
+   * Dfa StateIds are assigned after each level in the order ToDfa() would
+   * have found them, so the result equals ToDfa() for any thread_count.
+   * Nothing is logged.
+   */
+  [[nodiscard]] Dfa ToDfa(size_t thread_count) const {
+    if (thread_count == 1) {
+      return ToDfa();
+    }
+    const auto timer = StatsTimer{StatPhase::kToDfa};
+
+    constexpr auto kNoId = std::numeric_limits<StateId>::max();
+    struct Value {
+      StateId id = kNoId;
+      bool isFinal = false;
+      PatternIds patterns{};
+    };
+    using Table = ConcurrentSubsetTable<Value>;
+    struct Edge {
+      SymbolId symbol;
+      Table::Ref target;
+    };
+
+    const auto &dense_nfa = GetDenseNfa();
+    auto pool = ThreadPool{thread_count};
+    auto subsets = Table{pool.Size() * 8};
+    auto scratches = std::vector<DenseNfa::NextScratch>(pool.Size());
+    auto cur_subsets = std::vector<std::vector<uint32_t>>(pool.Size());
 
     auto dfa_table = Dfa::DfaTable{};
-    for (StateId i = 0; i < free_id; ++i) {
-      dfa_table.emplace(i, Dfa::TransTable());
+    auto dfa_f = States{};
+    auto dfa_accept = AcceptTable{};
+
+    auto MakeValue = [&dense_nfa](StateId id, std::span<const uint32_t> subset) {
+      auto res = Value{id, dense_nfa.HasFinal(subset)};
+      if (res.isFinal) {
+        res.patterns = dense_nfa.GetPatterns(subset);
+      }
+      return res;
+    };
+    auto start = subsets.Insert(dense_nfa.closure.Get(dense_nfa.s), [&] {
+      return MakeValue(0, dense_nfa.closure.Get(dense_nfa.s));
+    });
+    if (auto &value = subsets.GetValue(start.first); value.isFinal) {
+      dfa_f.emplace(0);
+      AddPatterns(dfa_accept, 0, std::move(value.patterns));
     }
-    for (const auto &[u_subset, trans_table] : subset_table) {
-      for (const auto &[terminal, v_subset] : trans_table)
-        dfa_table[new_ids[u_subset]].emplace(terminal, new_ids[v_subset]);
+    StateId free_id = 1;
+
+    auto frontier = std::vector<Table::Ref>{start.first};
+    auto next_frontier = std::vector<Table::Ref>{};
+    auto level_edges = std::vector<std::vector<Edge>>{};
+
+    for (StateId level_first = 0; !frontier.empty();
+         level_first += static_cast<StateId>(frontier.size()),
+                 std::swap(frontier, next_frontier)) {
+      level_edges.resize(frontier.size());
+      pool.ParallelFor(frontier.size(), 16, [&](size_t i, size_t thread) {
+        auto &cur_subset = cur_subsets[thread];
+        subsets.Get(frontier[i], cur_subset);
+        auto &edges = level_edges[i];
+        edges.clear();
+        dense_nfa.ForEachNext(
+            cur_subset, scratches[thread],
+            [&](SymbolId t, std::span<const uint32_t> next_subset) {
+              auto [ref, inserted] = subsets.Insert(
+                  next_subset, [&] { return MakeValue(kNoId, next_subset); });
+              edges.emplace_back(Edge{t, ref});
+            });
+      });
+
+      // Number new subsets in the order a sequential bfs finds them.
+      next_frontier.clear();
+      for (size_t i = 0; i < frontier.size(); ++i) {
+        auto &cur_trans_table = dfa_table[level_first + i];
+        for (const auto &[t, ref] : level_edges[i]) {
+          auto &value = subsets.GetValue(ref);
+          if (value.id == kNoId) {
+            value.id = free_id++;
+            dfa_table.try_emplace(value.id);
+            if (value.isFinal) {
+              dfa_f.emplace(value.id);
+              AddPatterns(dfa_accept, value.id, std::move(value.patterns));
+            }
+            next_frontier.emplace_back(ref);
+          }
+          cur_trans_table.emplace(dense_nfa.symbols.GetTerminal(t), value.id);
+        }
+      }
     }
 
+    Stats::Add(StatCounter::kSubsetsCreated, free_id);
+    Stats::Max(StatCounter::kPeakSubsets, free_id);
+    return Dfa(std::move(dfa_table), 0, std::move(dfa_f),
+               std::move(dfa_accept));
+  }
+
+ private:
+  /**
+   * ToDfa(resource). The ScSteps sent to sink are built only if there is
+   * one.
+   */
+  [[nodiscard]] Dfa SubsetConstruction(std::pmr::memory_resource &resource,
+                                       ScSink *sink) const {
+    if (sink != nullptr) {
+      sink->OnSource(ToFlatNfa());
+    }
+    const auto timer = StatsTimer{StatPhase::kToDfa};
+    auto stats_resource = StatsResource{resource};
+    auto &scratch_resource = stats_resource.Get();
+
+    const auto &dense_nfa = GetDenseNfa();
+
+    auto subsets = SubsetTable{&scratch_resource};
+    auto dfa_table = Dfa::DfaTable{};
     auto dfa_f = States{};
-    for (const auto &subset : subset_table | std::ranges::views::keys) {
-      for (const auto &f : f_) {
-        if (subset.contains(f)) {
-          dfa_f.insert(new_ids[subset]);
-          break;
+    auto dfa_accept = AcceptTable{};
+    // Step of the current subset, if there is a sink.
+    auto step = ScStep{};
+    auto *cur_step = static_cast<ScStep *>(nullptr);
+
+    auto InsertSubset = [&](std::span<const uint32_t> subset) -> StateId {
+      auto [id, inserted] = subsets.Insert(subset);
+      if (inserted) {
+        Stats::Add(StatCounter::kSubsetsCreated);
+        dfa_table.try_emplace(id);
+        if (dense_nfa.HasFinal(subset)) {
+          dfa_f.emplace(id);
+          AddPatterns(dfa_accept, id, dense_nfa.GetPatterns(subset));
         }
+        if (cur_step != nullptr) {
+          cur_step->newSubsets.emplace_back(dense_nfa.ToFlatStates(subset));
+          cur_step->waitList.emplace_back(dense_nfa.ToFlatStates(subset));
+        }
+      }
+      return id;
+    };
+
+    auto scratch = DenseNfa::NextScratch{&scratch_resource};
+    auto cur_subset = std::pmr::vector<uint32_t>{&scratch_resource};
+
+    InsertSubset(dense_nfa.closure.Get(dense_nfa.s));
+
+    // Subset ids are handed out in discovery order, so they are the queue.
+    for (StateId cur_id = 0; cur_id < subsets.Size(); ++cur_id) {
+      const auto subset = subsets.Get(cur_id);
+      cur_subset.assign(subset.begin(), subset.end());
+
+      if (sink != nullptr) {
+        step = ScStep{};
+        step.curSubset = dense_nfa.ToFlatStates(cur_subset);
+        for (auto id = cur_id + 1; id < subsets.Size(); ++id) {
+          step.waitList.emplace_back(dense_nfa.ToFlatStates(subsets.Get(id)));
+        }
+        cur_step = &step;
+      }
+
+      auto &cur_trans_table = dfa_table[cur_id];
+      dense_nfa.ForEachNext(
+          cur_subset, scratch,
+          [&](SymbolId t, std::span<const uint32_t> next_subset) {
+            auto next_id = InsertSubset(next_subset);
+            cur_trans_table.emplace(dense_nfa.symbols.GetTerminal(t),
+                                    next_id);
+            if (cur_step != nullptr) {
+              cur_step->scEdges.emplace_back(
+                  cur_step->curSubset, dense_nfa.symbols.GetTerminal(t),
+                  dense_nfa.ToFlatStates(next_subset));
+            }
+          });
+      if (cur_step != nullptr) {
+        sink->OnStep(std::move(step));
       }
     }
 
-    auto res = Dfa(std::move(dfa_table), new_ids[{s_}], std::move(dfa_f));
-#ifdef REGEX_FA_LOGGER
-    logger.sc_log.target = res.ToFlatDfa();
-#endif
+    Stats::Max(StatCounter::kPeakSubsets, subsets.Size());
+    auto res =
+        Dfa(std::move(dfa_table), 0, std::move(dfa_f), std::move(dfa_accept));
+    if (sink != nullptr) {
+      sink->OnTarget(res.ToFlatDfa());
+    }
     return res;
   }
+
+  /**
+   * Record the patterns of a final Dfa state, unless they are the default.
+   */
+  static void AddPatterns(AcceptTable &accept, StateId id,
+                          PatternIds patterns) {
+    if (!std::ranges::equal(patterns, kDefaultPatterns)) {
+      accept.emplace(id, std::move(patterns));
+    }
+  }
 };
 
 }  // namespace regex_fa
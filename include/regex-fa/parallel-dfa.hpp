@@ -0,0 +1,280 @@
+#ifndef REGEX_FA_PARALLEL_DFA_HPP
+#define REGEX_FA_PARALLEL_DFA_HPP
+
+#include "dense-dfa-view.hpp"
+#include "fa-include.hpp"
+#include "thread-pool.hpp"
+
+namespace regex_fa {
+
+/**
+ * Matching of one large input on several threads.
+ * The input is cut into chunks that are run in parallel, every chunk but the
+ * first without knowing its start state:
+ *   Dfas with at most Options::maxEnumeratedStates states run each chunk from
+ *   all states at once, giving a map start -> end per chunk. Runs that reach
+ *   the same state are merged, which in practice happens within a few bytes,
+ *   so this costs little more than a single run.
+ *   Larger Dfas speculate: a chunk starts from the state reached over the
+ *   Options::lookback bytes before it, and keeps the states at checkpoints.
+ *   A wrong guess is fixed by rerunning the chunk from the real start until
+ *   it meets a checkpoint state, after which both runs agree.
+ * The real start state of each chunk is then found in chunk order, one map
+ * lookup or check per chunk.
+ * The DenseDfaView must outlive the ParallelDfa. Not thread safe, like
+ * ThreadPool.
+ */
+class ParallelDfa {
+ public:
+  using DenseStateId = DenseDfaView::DenseStateId;
+
+  static constexpr DenseStateId kDeadState = DenseDfaView::kDeadState;
+
+  struct Options {
+    size_t chunkSize = size_t{1} << 20;
+    size_t maxEnumeratedStates = 64;
+    size_t lookback = 4096;
+  };
+
+ private:
+  static constexpr size_t kCheckpoint = 4096;  // bytes between checkpoints
+
+  struct Chunk {
+    std::span<const std::byte> input;
+    std::vector<DenseStateId> map;  // start -> end, if enumerated
+    DenseStateId guess{kDeadState};  // speculated start
+    std::vector<DenseStateId> checkpoints;  // state at each kCheckpoint bytes
+    DenseStateId start{kDeadState};         // real start
+  };
+
+  DenseDfaView dfa_;
+  Options options_;
+  ThreadPool pool_;
+  std::vector<Chunk> chunks_;
+
+ public:
+  /**
+   * @param thread_count Threads in total, 0 means one per core.
+   */
+  ParallelDfa(const DenseDfaView &dfa, size_t thread_count)
+      : ParallelDfa(dfa, thread_count, Options{}) {}
+
+  ParallelDfa(const DenseDfaView &dfa, size_t thread_count, Options options)
+      : dfa_(dfa), options_(options), pool_(thread_count) {
+    assert(options_.chunkSize > 0);
+  }
+
+  /**
+   * State reached from the start state over input, or kDeadState.
+   */
+  [[nodiscard]] DenseStateId Run(std::span<const std::byte> input) {
+    Split(input);
+    FindStarts();
+    return GetEnd(chunks_.size() - 1);
+  }
+
+  [[nodiscard]] bool Accepts(std::span<const std::byte> input) {
+    const auto u = Run(input);
+    return u != kDeadState && dfa_.IsAccepting(u);
+  }
+
+  [[nodiscard]] bool Accepts(std::string_view input) {
+    return Accepts(DenseDfaView::AsBytes(input));
+  }
+
+  /**
+   * Every end of an accepted prefix, in ascending order: i such that
+   * input[0, i) is accepted. For a Dfa of .*(pattern) these are the ends of
+   * all matches of pattern.
+   */
+  [[nodiscard]] std::vector<size_t> MatchEnds(
+      std::span<const std::byte> input) {
+    Split(input);
+    FindStarts();
+
+    auto ends = std::vector<std::vector<size_t>>(chunks_.size());
+    pool_.ParallelFor(chunks_.size(), 1, [&](size_t k, size_t) {
+      const auto &chunk = chunks_[k];
+      auto offset = static_cast<size_t>(chunk.input.data() - input.data());
+      auto u = chunk.start;
+      if (k == 0 && dfa_.IsAccepting(u)) {
+        ends[k].emplace_back(0);
+      }
+      for (size_t i = 0; i < chunk.input.size() && u != kDeadState; ++i) {
+        u = dfa_.Next(u, chunk.input[i]);
+        if (u != kDeadState && dfa_.IsAccepting(u)) {
+          ends[k].emplace_back(offset + i + 1);
+        }
+      }
+    });
+
+    auto res = std::vector<size_t>{};
+    for (const auto &chunk_ends : ends) {
+      res.insert(res.end(), chunk_ends.begin(), chunk_ends.end());
+    }
+    return res;
+  }
+
+  [[nodiscard]] std::vector<size_t> MatchEnds(std::string_view input) {
+    return MatchEnds(DenseDfaView::AsBytes(input));
+  }
+
+ private:
+  [[nodiscard]] bool IsEnumerated() const {
+    return dfa_.StateCount() <= options_.maxEnumeratedStates;
+  }
+
+  [[nodiscard]] DenseStateId Next(DenseStateId u, std::byte byte) const {
+    return u == kDeadState ? kDeadState : dfa_.Next(u, byte);
+  }
+
+  [[nodiscard]] DenseStateId RunFrom(DenseStateId u,
+                                     std::span<const std::byte> input) const {
+    for (size_t i = 0; i < input.size() && u != kDeadState; ++i) {
+      u = dfa_.Next(u, input[i]);
+    }
+    return u;
+  }
+
+  /**
+   * Cut input into chunks and run them in parallel. The first chunk runs
+   * like a speculated one with a right guess.
+   */
+  void Split(std::span<const std::byte> input) {
+    chunks_.clear();
+    for (size_t begin = 0; begin == 0 || begin < input.size();
+         begin += options_.chunkSize) {
+      auto &chunk = chunks_.emplace_back();
+      chunk.input = input.subspan(
+          begin, std::min(options_.chunkSize, input.size() - begin));
+    }
+    chunks_.front().start = dfa_.GetS();
+
+    pool_.ParallelFor(chunks_.size(), 1, [&](size_t k, size_t) {
+      auto &chunk = chunks_[k];
+      if (k == 0) {
+        chunk.guess = chunk.start;
+      } else if (IsEnumerated()) {
+        chunk.map = RunAll(chunk.input);
+        return;
+      } else {
+        const auto lookback = std::min<size_t>(
+            options_.lookback,
+            static_cast<size_t>(chunk.input.data() - input.data()));
+        chunk.guess = RunFrom(
+            dfa_.GetS(), {chunk.input.data() - lookback, chunk.input.data()});
+      }
+
+      chunk.checkpoints.clear();
+      auto u = chunk.guess;
+      for (size_t k = 0; k < chunk.input.size(); ++k) {
+        u = Next(u, chunk.input[k]);
+        if ((k + 1) % kCheckpoint == 0 || k + 1 == chunk.input.size()) {
+          chunk.checkpoints.emplace_back(u);
+        }
+      }
+    });
+  }
+
+  /**
+   * Map start -> end of input for every state. Runs from different states
+   * that meet are merged.
+   */
+  [[nodiscard]] std::vector<DenseStateId> RunAll(
+      std::span<const std::byte> input) const {
+    const auto n = dfa_.StateCount();
+    auto runs = std::vector<DenseStateId>(n);  // distinct current states
+    auto run_of = std::vector<uint32_t>(n);    // start -> index in runs
+    for (DenseStateId u = 0; u < n; ++u) {
+      runs[u] = u;
+      run_of[u] = u;
+    }
+
+    constexpr size_t kMergeEvery = 64;
+    auto merged = std::vector<uint32_t>(n + 1);  // state (dead last) -> run
+    auto remap = std::vector<uint32_t>{};
+    for (size_t begin = 0; begin < input.size(); begin += kMergeEvery) {
+      const auto end = std::min(input.size(), begin + kMergeEvery);
+      for (auto &u : runs) {
+        for (auto i = begin; i < end; ++i) {
+          u = Next(u, input[i]);
+        }
+      }
+      if (runs.size() == 1) {
+        runs.front() = RunFrom(runs.front(), input.subspan(end));
+        break;
+      }
+
+      // Merge runs in the same state.
+      constexpr auto kNoRun = std::numeric_limits<uint32_t>::max();
+      std::ranges::fill(merged, kNoRun);
+      remap.resize(runs.size());
+      size_t run_count = 0;
+      for (size_t j = 0; j < runs.size(); ++j) {
+        const auto key = runs[j] == kDeadState ? n : runs[j];
+        if (merged[key] == kNoRun) {
+          merged[key] = static_cast<uint32_t>(run_count);
+          runs[run_count++] = runs[j];
+        }
+        remap[j] = merged[key];
+      }
+      runs.resize(run_count);
+      for (auto &run : run_of) {
+        run = remap[run];
+      }
+    }
+
+    auto res = std::vector<DenseStateId>(n);
+    for (DenseStateId u = 0; u < n; ++u) {
+      res[u] = runs[run_of[u]];
+    }
+    return res;
+  }
+
+  /**
+   * Real start state of every chunk, in chunk order.
+   */
+  void FindStarts() {
+    for (size_t k = 1; k < chunks_.size(); ++k) {
+      chunks_[k].start = GetEnd(k - 1);
+    }
+  }
+
+  /**
+   * End state of chunk k, its start must be known.
+   */
+  [[nodiscard]] DenseStateId GetEnd(size_t k) const {
+    const auto &chunk = chunks_[k];
+    if (k > 0 && IsEnumerated()) {
+      return chunk.start == kDeadState ? kDeadState : chunk.map[chunk.start];
+    }
+    return FixGuess(chunk);
+  }
+
+  /**
+   * End state of a speculated chunk from its real start.
+   */
+  [[nodiscard]] DenseStateId FixGuess(const Chunk &chunk) const {
+    if (chunk.input.empty()) {
+      return chunk.start;
+    }
+    if (chunk.start == chunk.guess) {
+      return chunk.checkpoints.back();
+    }
+    auto u = chunk.start;
+    for (size_t k = 0; k < chunk.input.size(); ++k) {
+      u = Next(u, chunk.input[k]);
+      if ((k + 1) % kCheckpoint == 0 || k + 1 == chunk.input.size()) {
+        if (u == chunk.checkpoints[k / kCheckpoint]) {
+          // Same state at the same position, the rest of the runs agree.
+          return chunk.checkpoints.back();
+        }
+      }
+    }
+    return u;
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_PARALLEL_DFA_HPP
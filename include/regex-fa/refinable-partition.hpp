@@ -0,0 +1,148 @@
+#ifndef REGEX_FA_REFINABLE_PARTITION_HPP
+#define REGEX_FA_REFINABLE_PARTITION_HPP
+
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Refinable partition of elements 0..n-1 stored in flat arrays
+ * (Valmari-Lehtinen).
+ * Elements of block b are elems_[first_[b], end_[b]), the marked ones are
+ * kept in front, in elems_[first_[b], mid_[b]).
+ */
+class RefinablePartition {
+ public:
+  using Element = uint32_t;
+  using BlockId = uint32_t;
+
+ private:
+  std::pmr::vector<Element> elems_;
+  std::pmr::vector<uint32_t> loc_;   // element -> position in elems_
+  std::pmr::vector<BlockId> block_;  // element -> block
+  std::pmr::vector<uint32_t> first_, mid_, end_;
+  std::pmr::vector<BlockId> touched_;
+
+ public:
+  RefinablePartition() = default;
+
+  /**
+   * Build initial blocks from a class per element.
+   * Blocks are numbered by class in ascending order, empty classes are
+   * skipped.
+   * @param classes classes[e] is the class of element e.
+   * @param class_count All classes are less than class_count.
+   * @param resource Memory of the partition.
+   */
+  RefinablePartition(
+      const std::vector<uint32_t> &classes, size_t class_count,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : elems_(classes.size(), resource),
+        loc_(classes.size(), resource),
+        block_(classes.size(), resource),
+        first_(resource),
+        mid_(resource),
+        end_(resource),
+        touched_(resource) {
+    // Counting sort elements by class.
+    auto class_first = std::pmr::vector<uint32_t>(class_count + 1, 0, resource);
+    for (auto c : classes) {
+      ++class_first[c + 1];
+    }
+    for (size_t c = 0; c < class_count; ++c) {
+      class_first[c + 1] += class_first[c];
+    }
+
+    auto class_block = std::pmr::vector<BlockId>(class_count, resource);
+    for (size_t c = 0; c < class_count; ++c) {
+      if (class_first[c] == class_first[c + 1]) {
+        continue;
+      }
+      class_block[c] = static_cast<BlockId>(first_.size());
+      first_.emplace_back(class_first[c]);
+      mid_.emplace_back(class_first[c]);
+      end_.emplace_back(class_first[c + 1]);
+    }
+
+    for (Element e = 0; e < classes.size(); ++e) {
+      auto pos = class_first[classes[e]]++;
+      elems_[pos] = e;
+      loc_[e] = pos;
+      block_[e] = class_block[classes[e]];
+    }
+  }
+
+  [[nodiscard]] size_t Size() const { return elems_.size(); }
+  [[nodiscard]] size_t BlockCount() const { return first_.size(); }
+  [[nodiscard]] BlockId BlockOf(Element e) const { return block_[e]; }
+  [[nodiscard]] size_t BlockSize(BlockId b) const {
+    return end_[b] - first_[b];
+  }
+
+  [[nodiscard]] std::span<const Element> Elements(BlockId b) const {
+    return {elems_.data() + first_[b], elems_.data() + end_[b]};
+  }
+
+  /**
+   * Move e into the marked part of its block.
+   * Marking an element twice is a no-op.
+   */
+  void Mark(Element e) {
+    auto b = block_[e];
+    auto pos = loc_[e];
+    if (pos < mid_[b]) {
+      return;
+    }
+    if (mid_[b] == first_[b]) {
+      touched_.emplace_back(b);
+    }
+    auto other = elems_[mid_[b]];
+    elems_[pos] = other;
+    loc_[other] = pos;
+    elems_[mid_[b]] = e;
+    loc_[e] = mid_[b];
+    ++mid_[b];
+  }
+
+  /**
+   * Split every touched block into its marked and unmarked parts.
+   * The smaller part becomes a new block, the larger part keeps the old id.
+   * Blocks that are wholly marked are left as they are.
+   * @param on_split Called as on_split(old_block, new_block) for each split.
+   */
+  template <typename OnSplit>
+  void SplitMarked(OnSplit &&on_split) {
+    for (auto b : touched_) {
+      auto marked = mid_[b] - first_[b];
+      auto unmarked = end_[b] - mid_[b];
+
+      if (unmarked == 0) {
+        mid_[b] = first_[b];
+        continue;
+      }
+
+      auto new_b = static_cast<BlockId>(first_.size());
+      if (marked <= unmarked) {
+        first_.emplace_back(first_[b]);
+        end_.emplace_back(mid_[b]);
+        first_[b] = mid_[b];
+      } else {
+        first_.emplace_back(mid_[b]);
+        end_.emplace_back(end_[b]);
+        end_[b] = mid_[b];
+      }
+      mid_.emplace_back(first_[new_b]);
+      mid_[b] = first_[b];
+
+      for (auto pos = first_[new_b]; pos < end_[new_b]; ++pos) {
+        block_[elems_[pos]] = new_b;
+      }
+      on_split(b, new_b);
+    }
+    touched_.clear();
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_REFINABLE_PARTITION_HPP
@@ -1,8 +1,27 @@
 #ifndef REGEX_FA_TEST_REGEX_FA_HPP
 #define REGEX_FA_TEST_REGEX_FA_HPP
 
+#include "alphabet.hpp"
+#include "codegen.hpp"
+#include "dense-dfa-file.hpp"
+#include "dense-dfa-view.hpp"
+#include "dense-dfa.hpp"
+#include "dense-nfa.hpp"
+#include "dfa-product.hpp"
+#include "dfa-scanner.hpp"
 #include "dfa.hpp"
+#include "epsilon-closure.hpp"
 #include "fa-include.hpp"
+#include "incremental-dfa.hpp"
+#include "lazy-dfa.hpp"
+#include "multi-stream-dfa.hpp"
 #include "nfa.hpp"
+#include "parallel-dfa.hpp"
+#include "refinable-partition.hpp"
+#include "regex.hpp"
+#include "static-dfa.hpp"
+#include "stats.hpp"
+#include "subset-table.hpp"
+#include "thread-pool.hpp"
 
 #endif  // REGEX_FA_TEST_REGEX_FA_HPP
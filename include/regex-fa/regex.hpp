@@ -0,0 +1,595 @@
+#ifndef REGEX_FA_REGEX_HPP
+#define REGEX_FA_REGEX_HPP
+
+#include "fa-include.hpp"
+#include "nfa.hpp"
+#include "stats.hpp"
+
+namespace regex_fa {
+
+class RegexError : public std::runtime_error {
+ private:
+  size_t position_;
+
+ public:
+  RegexError(const std::string &what, size_t position)
+      : std::runtime_error(what + " at " + std::to_string(position)),
+        position_(position) {}
+
+  /**
+   * Offset in the pattern where the error was found.
+   */
+  [[nodiscard]] size_t GetPosition() const { return position_; }
+};
+
+/**
+ * Set of bytes, bit b of words[b / 64] is byte b.
+ */
+struct ByteSet {
+  std::array<uint64_t, 4> words{};
+
+  constexpr void Insert(uint8_t b) {
+    words[b / 64] |= uint64_t{1} << (b % 64);
+  }
+
+  constexpr void InsertRange(uint8_t first, uint8_t last) {
+    for (auto b = unsigned{first}; b <= last; ++b) {
+      Insert(static_cast<uint8_t>(b));
+    }
+  }
+
+  constexpr void Insert(const ByteSet &other) {
+    for (size_t i = 0; i < words.size(); ++i) {
+      words[i] |= other.words[i];
+    }
+  }
+
+  constexpr void Invert() {
+    for (auto &word : words) {
+      word = ~word;
+    }
+  }
+
+  [[nodiscard]] constexpr bool Contains(uint8_t b) const {
+    return (words[b / 64] >> (b % 64)) & 1;
+  }
+
+  bool operator==(const ByteSet &) const = default;
+};
+
+/**
+ * Regex AST node. Nodes live in RegexAst's arena and refer to each other by
+ * index, children always before their parent.
+ */
+struct RegexNode {
+  enum class Kind : uint8_t {
+    kEmpty,      // matches ""
+    kBytes,      // matches one byte of bytes
+    kConcat,     // left right
+    kAlternate,  // left | right
+    kStar,       // left*
+    kPlus,       // left+
+    kOptional,   // left?
+  };
+
+  Kind kind{};
+  ByteSet bytes{};
+  uint32_t left{};
+  uint32_t right{};
+};
+
+struct RegexAst {
+  std::vector<RegexNode> nodes{};
+  uint32_t root{};
+};
+
+/**
+ * Recursive descent parser for
+ *   alternate := concat ('|' concat)*
+ *   concat    := repeat*
+ *   repeat    := atom ('*' | '+' | '?' | '{m}' | '{m,}' | '{m,n}')*
+ *   atom      := '(' alternate ')' | '[' class ']' | '.' | '\' escape | byte
+ * Bounded repetition is expanded into copies of its operand.
+ */
+class RegexParser {
+ public:
+  static constexpr size_t kMaxRepeat = 1000;
+
+ private:
+  std::string_view pattern_;
+  size_t pos_{0};
+  RegexAst ast_{};
+
+ public:
+  constexpr explicit RegexParser(std::string_view pattern)
+      : pattern_(pattern) {}
+
+  [[nodiscard]] constexpr RegexAst Parse() && {
+    ast_.root = ParseAlternate();
+    if (pos_ != pattern_.size()) {
+      Fail("Unmatched ')'");
+    }
+    return std::move(ast_);
+  }
+
+ private:
+  [[noreturn]] void Fail(const char *what) const {
+    throw RegexError{what, pos_};
+  }
+
+  [[nodiscard]] constexpr bool AtEnd() const {
+    return pos_ == pattern_.size();
+  }
+
+  [[nodiscard]] constexpr char Peek() const { return pattern_[pos_]; }
+
+  constexpr char Take() {
+    if (AtEnd()) {
+      Fail("Unexpected end of pattern");
+    }
+    return pattern_[pos_++];
+  }
+
+  constexpr uint32_t AddNode(RegexNode node) {
+    ast_.nodes.emplace_back(node);
+    return static_cast<uint32_t>(ast_.nodes.size() - 1);
+  }
+
+  constexpr uint32_t AddNode(RegexNode::Kind kind, uint32_t left = 0,
+                             uint32_t right = 0) {
+    return AddNode(RegexNode{kind, {}, left, right});
+  }
+
+  constexpr uint32_t AddBytes(const ByteSet &bytes) {
+    return AddNode(RegexNode{RegexNode::Kind::kBytes, bytes, 0, 0});
+  }
+
+  constexpr uint32_t Copy(uint32_t id) {
+    auto node = ast_.nodes[id];
+    switch (node.kind) {
+      case RegexNode::Kind::kConcat:
+      case RegexNode::Kind::kAlternate:
+        node.left = Copy(node.left);
+        node.right = Copy(node.right);
+        break;
+      case RegexNode::Kind::kStar:
+      case RegexNode::Kind::kPlus:
+      case RegexNode::Kind::kOptional:
+        node.left = Copy(node.left);
+        break;
+      default:
+        break;
+    }
+    return AddNode(node);
+  }
+
+  constexpr uint32_t ParseAlternate() {
+    auto res = ParseConcat();
+    while (!AtEnd() && Peek() == '|') {
+      ++pos_;
+      auto right = ParseConcat();
+      res = AddNode(RegexNode::Kind::kAlternate, res, right);
+    }
+    return res;
+  }
+
+  constexpr uint32_t ParseConcat() {
+    auto res = std::optional<uint32_t>{};
+    while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+      auto right = ParseRepeat();
+      res = res.has_value()
+                ? AddNode(RegexNode::Kind::kConcat, res.value(), right)
+                : right;
+    }
+    return res.has_value() ? res.value() : AddNode(RegexNode::Kind::kEmpty);
+  }
+
+  constexpr uint32_t ParseRepeat() {
+    auto res = ParseAtom();
+    while (!AtEnd()) {
+      switch (Peek()) {
+        case '*':
+          ++pos_;
+          res = AddNode(RegexNode::Kind::kStar, res);
+          break;
+        case '+':
+          ++pos_;
+          res = AddNode(RegexNode::Kind::kPlus, res);
+          break;
+        case '?':
+          ++pos_;
+          res = AddNode(RegexNode::Kind::kOptional, res);
+          break;
+        case '{':
+          res = ParseBoundedRepeat(res);
+          break;
+        default:
+          return res;
+      }
+    }
+    return res;
+  }
+
+  constexpr size_t ParseNumber() {
+    if (AtEnd() || Peek() < '0' || Peek() > '9') {
+      Fail("Expected number");
+    }
+    size_t res = 0;
+    while (!AtEnd() && Peek() >= '0' && Peek() <= '9') {
+      res = res * 10 + (Take() - '0');
+      if (res > kMaxRepeat) {
+        Fail("Repetition count too large");
+      }
+    }
+    return res;
+  }
+
+  /**
+   * x{m} = x^m, x{m,} = x^m x*, x{m,n} = x^m (x (x ...)?)?.
+   */
+  constexpr uint32_t ParseBoundedRepeat(uint32_t operand) {
+    Take();  // '{'
+    const auto min = ParseNumber();
+    auto max = std::optional<size_t>{min};
+    if (!AtEnd() && Peek() == ',') {
+      ++pos_;
+      max = (!AtEnd() && Peek() == '}') ? std::nullopt
+                                        : std::optional{ParseNumber()};
+    }
+    if (Take() != '}') {
+      Fail("Expected '}'");
+    }
+    if (max.has_value() && max.value() < min) {
+      Fail("Bad repetition range");
+    }
+
+    // The first use takes operand itself, later ones take copies.
+    auto used = false;
+    auto Operand = [this, operand, &used]() -> uint32_t {
+      return std::exchange(used, true) ? Copy(operand) : operand;
+    };
+
+    auto res = std::optional<uint32_t>{};
+    for (size_t i = 0; i < min; ++i) {
+      auto x = Operand();
+      res = res.has_value() ? AddNode(RegexNode::Kind::kConcat, res.value(), x)
+                            : x;
+    }
+
+    auto tail = std::optional<uint32_t>{};
+    if (!max.has_value()) {
+      tail = AddNode(RegexNode::Kind::kStar, Operand());
+    } else {
+      for (auto i = min; i < max.value(); ++i) {
+        auto x = Operand();
+        tail = AddNode(RegexNode::Kind::kOptional,
+                       tail.has_value()
+                           ? AddNode(RegexNode::Kind::kConcat, x, tail.value())
+                           : x);
+      }
+    }
+
+    if (tail.has_value()) {
+      res = res.has_value()
+                ? AddNode(RegexNode::Kind::kConcat, res.value(), tail.value())
+                : tail;
+    }
+    return res.has_value() ? res.value() : AddNode(RegexNode::Kind::kEmpty);
+  }
+
+  constexpr uint32_t ParseAtom() {
+    switch (auto c = Take()) {
+      case '(': {
+        auto res = ParseAlternate();
+        if (AtEnd() || Take() != ')') {
+          Fail("Expected ')'");
+        }
+        return res;
+      }
+      case '[':
+        return AddBytes(ParseClass());
+      case '.': {
+        auto bytes = ByteSet{};
+        bytes.Insert('\n');
+        bytes.Invert();
+        return AddBytes(bytes);
+      }
+      case '\\':
+        return AddBytes(ParseEscape());
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+        --pos_;
+        Fail("Nothing to repeat");
+      case '^':
+      case '$':
+        --pos_;
+        Fail("Anchors are not supported");
+      default: {
+        auto bytes = ByteSet{};
+        bytes.Insert(static_cast<uint8_t>(c));
+        return AddBytes(bytes);
+      }
+    }
+  }
+
+  static constexpr uint8_t HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 16;
+  }
+
+  /**
+   * Escape after '\'. Unknown escapes stand for the byte itself.
+   */
+  constexpr ByteSet ParseEscape() {
+    auto res = ByteSet{};
+    auto c = Take();
+    switch (c) {
+      case 'd':
+      case 'D':
+        res.InsertRange('0', '9');
+        break;
+      case 'w':
+      case 'W':
+        res.InsertRange('a', 'z');
+        res.InsertRange('A', 'Z');
+        res.InsertRange('0', '9');
+        res.Insert('_');
+        break;
+      case 's':
+      case 'S':
+        for (auto b : {' ', '\t', '\n', '\r', '\f', '\v'}) {
+          res.Insert(b);
+        }
+        break;
+      case 'n':
+        res.Insert('\n');
+        break;
+      case 't':
+        res.Insert('\t');
+        break;
+      case 'r':
+        res.Insert('\r');
+        break;
+      case 'f':
+        res.Insert('\f');
+        break;
+      case 'v':
+        res.Insert('\v');
+        break;
+      case '0':
+        res.Insert(0);
+        break;
+      case 'x': {
+        auto high = HexDigit(Take());
+        auto low = HexDigit(Take());
+        if (high > 15 || low > 15) {
+          Fail("Bad \\x escape");
+        }
+        res.Insert(static_cast<uint8_t>(high * 16 + low));
+        break;
+      }
+      default:
+        res.Insert(static_cast<uint8_t>(c));
+        break;
+    }
+    if (c == 'D' || c == 'W' || c == 'S') {
+      res.Invert();
+    }
+    return res;
+  }
+
+  /**
+   * One byte or escape inside a class.
+   */
+  constexpr ByteSet ParseClassAtom() {
+    auto c = Take();
+    if (c == '\\') {
+      return ParseEscape();
+    }
+    auto res = ByteSet{};
+    res.Insert(static_cast<uint8_t>(c));
+    return res;
+  }
+
+  /**
+   * The byte of a set with exactly one byte.
+   */
+  static constexpr std::optional<uint8_t> SingleByte(const ByteSet &set) {
+    auto res = std::optional<uint8_t>{};
+    for (unsigned b = 0; b < 256; ++b) {
+      if (set.Contains(static_cast<uint8_t>(b))) {
+        if (res.has_value()) {
+          return std::nullopt;
+        }
+        res = static_cast<uint8_t>(b);
+      }
+    }
+    return res;
+  }
+
+  /**
+   * Class after '['. A leading ']' and a leading or trailing '-' are
+   * literal.
+   */
+  constexpr ByteSet ParseClass() {
+    auto res = ByteSet{};
+    auto negate = !AtEnd() && Peek() == '^';
+    if (negate) {
+      ++pos_;
+    }
+
+    auto first = true;
+    while (first || AtEnd() || Peek() != ']') {
+      first = false;
+      auto set = ParseClassAtom();
+      auto low = SingleByte(set);
+      if (!low.has_value() || pos_ + 1 >= pattern_.size() || Peek() != '-' ||
+          pattern_[pos_ + 1] == ']') {
+        res.Insert(set);
+        continue;
+      }
+
+      ++pos_;  // '-'
+      auto high = SingleByte(ParseClassAtom());
+      if (!high.has_value() || high.value() < low.value()) {
+        Fail("Bad class range");
+      }
+      res.InsertRange(low.value(), high.value());
+    }
+    Take();  // ']'
+
+    if (negate) {
+      res.Invert();
+    }
+    return res;
+  }
+};
+
+/**
+ * Glushkov (position) automaton, epsilon free.
+ * State 0 is the start, states 1..n are the byte positions of the pattern.
+ * Every transition into position q reads a byte of bytes[q].
+ */
+struct GlushkovAutomaton {
+  std::vector<ByteSet> bytes{};               // bytes[0] is unused
+  std::vector<std::vector<uint32_t>> follow{};  // p --bytes[q]-> q
+  std::vector<uint32_t> finals{};
+};
+
+/**
+ * Compile pattern into its Glushkov automaton.
+ * @throw RegexError If pattern is malformed.
+ */
+[[nodiscard]] constexpr GlushkovAutomaton CompileGlushkov(
+    std::string_view pattern) {
+  const auto ast = RegexParser{pattern}.Parse();
+  const auto &nodes = ast.nodes;
+
+  struct Sets {
+    bool nullable{};
+    std::vector<uint32_t> first{};
+    std::vector<uint32_t> last{};
+  };
+
+  auto Union = [](const std::vector<uint32_t> &a,
+                  const std::vector<uint32_t> &b) {
+    auto res = std::vector<uint32_t>{};
+    std::ranges::set_union(a, b, std::back_inserter(res));
+    return res;
+  };
+
+  auto res = GlushkovAutomaton{};
+  res.bytes.emplace_back();
+  res.follow.emplace_back();
+
+  auto Follow = [&res](const std::vector<uint32_t> &last,
+                       const std::vector<uint32_t> &first) {
+    for (auto p : last) {
+      res.follow[p].insert(res.follow[p].end(), first.begin(), first.end());
+    }
+  };
+
+  // Children come before their parent, so one pass in index order works.
+  auto sets = std::vector<Sets>(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const auto &node = nodes[i];
+    auto &cur = sets[i];
+    switch (node.kind) {
+      case RegexNode::Kind::kEmpty:
+        cur.nullable = true;
+        break;
+      case RegexNode::Kind::kBytes: {
+        auto p = static_cast<uint32_t>(res.bytes.size());
+        res.bytes.emplace_back(node.bytes);
+        res.follow.emplace_back();
+        cur.first = cur.last = {p};
+        break;
+      }
+      case RegexNode::Kind::kConcat: {
+        auto left = std::move(sets[node.left]);
+        auto right = std::move(sets[node.right]);
+        Follow(left.last, right.first);
+        cur.nullable = left.nullable && right.nullable;
+        // Plain ifs: a conditional over a prvalue and an xvalue vector is
+        // not constant-evaluable in GCC 12.
+        if (left.nullable) {
+          cur.first = Union(left.first, right.first);
+        } else {
+          cur.first = std::move(left.first);
+        }
+        if (right.nullable) {
+          cur.last = Union(left.last, right.last);
+        } else {
+          cur.last = std::move(right.last);
+        }
+        break;
+      }
+      case RegexNode::Kind::kAlternate: {
+        auto left = std::move(sets[node.left]);
+        auto right = std::move(sets[node.right]);
+        cur.nullable = left.nullable || right.nullable;
+        cur.first = Union(left.first, right.first);
+        cur.last = Union(left.last, right.last);
+        break;
+      }
+      case RegexNode::Kind::kStar:
+      case RegexNode::Kind::kPlus:
+      case RegexNode::Kind::kOptional: {
+        cur = std::move(sets[node.left]);
+        if (node.kind != RegexNode::Kind::kOptional) {
+          Follow(cur.last, cur.first);
+        }
+        if (node.kind != RegexNode::Kind::kPlus) {
+          cur.nullable = true;
+        }
+        break;
+      }
+    }
+  }
+
+  const auto &root = sets[ast.root];
+  res.follow[0] = root.first;
+  for (auto &follow : res.follow) {
+    std::ranges::sort(follow);
+    auto [first, last] = std::ranges::unique(follow);
+    follow.erase(first, last);
+  }
+  if (root.nullable) {
+    res.finals.emplace_back(0);
+  }
+  res.finals.insert(res.finals.end(), root.last.begin(), root.last.end());
+  return res;
+}
+
+/**
+ * Compile pattern into an epsilon free Nfa, one single-byte Terminal per
+ * byte.
+ * @throw RegexError If pattern is malformed.
+ */
+[[nodiscard]] inline Nfa RegexToNfa(std::string_view pattern) {
+  const auto timer = StatsTimer{StatPhase::kRegexToNfa};
+  const auto glushkov = CompileGlushkov(pattern);
+
+  auto nfa_table = Nfa::NfaTable{};
+  for (StateId p = 0; p < glushkov.follow.size(); ++p) {
+    auto &trans_table = nfa_table[p];
+    for (auto q : glushkov.follow[p]) {
+      for (unsigned b = 0; b < 256; ++b) {
+        if (glushkov.bytes[q].Contains(static_cast<uint8_t>(b))) {
+          trans_table[Terminal(1, static_cast<char>(b))].emplace(q);
+        }
+      }
+    }
+  }
+
+  auto f = States{glushkov.finals.begin(), glushkov.finals.end()};
+  return Nfa{std::move(nfa_table), 0, std::move(f)};
+}
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_REGEX_HPP
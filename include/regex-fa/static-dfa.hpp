@@ -0,0 +1,274 @@
+#ifndef REGEX_FA_STATIC_DFA_HPP
+#define REGEX_FA_STATIC_DFA_HPP
+
+#include "dense-dfa-view.hpp"
+#include "fa-include.hpp"
+#include "regex.hpp"
+
+namespace regex_fa {
+
+/**
+ * String literal usable as a template argument, e.g. StaticDfa<"a+b">.
+ */
+template <size_t N>
+struct FixedString {
+  std::array<char, N> chars{};
+
+  consteval FixedString(const char (&s)[N]) {
+    std::copy_n(s, N, chars.begin());
+  }
+
+  [[nodiscard]] constexpr std::string_view View() const {
+    return {chars.data(), N - 1};
+  }
+};
+
+/**
+ * Dfa of a pattern fixed at build time, determinized and minimized during
+ * compilation. Nothing is built at runtime: the tables are static constexpr
+ * arrays and all matching functions are constexpr.
+ * The pattern is compiled by CompileGlushkov, its bytes grouped into
+ * equivalence classes and the subset construction minimized by Moore's
+ * algorithm. The Dfa is complete: state 0 is the dead state, from which
+ * nothing is accepted, so matching needs no branch for missing transitions.
+ * A malformed pattern is a compile error.
+ */
+template <FixedString kPattern>
+class StaticDfa {
+ private:
+  /**
+   * Minimal Dfa in vectors, only alive during constant evaluation.
+   */
+  struct Compiled {
+    std::array<uint8_t, 256> byteClasses{};
+    size_t classCount{0};
+    size_t stateCount{0};
+    std::vector<uint32_t> table{};
+    std::vector<uint8_t> accepting{};
+    uint32_t s{0};
+  };
+
+  [[nodiscard]] static constexpr Compiled Compile() {
+    const auto glushkov = CompileGlushkov(kPattern.View());
+    auto res = Compiled{};
+
+    // Split every class by whether position q reads its bytes.
+    constexpr auto kNone = std::numeric_limits<uint32_t>::max();
+    res.classCount = 1;
+    for (size_t q = 1; q < glushkov.bytes.size(); ++q) {
+      auto ids = std::vector<uint32_t>(res.classCount * 2, kNone);
+      size_t class_count = 0;
+      for (unsigned b = 0; b < 256; ++b) {
+        auto &id = ids[res.byteClasses[b] * 2 +
+                       glushkov.bytes[q].Contains(static_cast<uint8_t>(b))];
+        if (id == kNone) {
+          id = static_cast<uint32_t>(class_count++);
+        }
+        res.byteClasses[b] = static_cast<uint8_t>(id);
+      }
+      res.classCount = class_count;
+    }
+    auto representatives = std::vector<uint8_t>(res.classCount);
+    for (unsigned b = 256; b-- > 0;) {
+      representatives[res.byteClasses[b]] = static_cast<uint8_t>(b);
+    }
+
+    // Subset construction, with the empty (dead) subset first.
+    auto subsets = std::vector<std::vector<uint32_t>>{{}, {0}};
+    auto table = std::vector<uint32_t>{};
+    for (size_t u = 0; u < subsets.size(); ++u) {
+      const auto subset = subsets[u];
+      for (auto byte : representatives) {
+        auto next = std::vector<uint32_t>{};
+        for (auto p : subset) {
+          for (auto q : glushkov.follow[p]) {
+            if (glushkov.bytes[q].Contains(byte)) {
+              next.emplace_back(q);
+            }
+          }
+        }
+        std::ranges::sort(next);
+        auto [first, last] = std::ranges::unique(next);
+        next.erase(first, last);
+
+        auto it = std::ranges::find(subsets, next);
+        table.emplace_back(static_cast<uint32_t>(it - subsets.begin()));
+        if (it == subsets.end()) {
+          subsets.emplace_back(std::move(next));
+        }
+      }
+    }
+
+    // Moore: refine by (block, successor blocks) until stable. Blocks are
+    // numbered in order of their first state, so the dead state stays 0.
+    const auto n = subsets.size();
+    auto accepting = std::vector<uint8_t>(n);
+    for (size_t u = 0; u < n; ++u) {
+      accepting[u] = std::ranges::any_of(subsets[u], [&glushkov](uint32_t p) {
+        return std::ranges::find(glushkov.finals, p) != glushkov.finals.end();
+      });
+    }
+    auto block = std::vector<uint32_t>{accepting.begin(), accepting.end()};
+    size_t block_count = 0;
+    auto representative_states = std::vector<size_t>{};
+    while (true) {
+      auto signatures = std::vector<std::vector<uint32_t>>{};
+      auto next_block = std::vector<uint32_t>(n);
+      representative_states.clear();
+      for (size_t u = 0; u < n; ++u) {
+        auto signature = std::vector<uint32_t>{block[u]};
+        for (size_t c = 0; c < res.classCount; ++c) {
+          signature.emplace_back(block[table[u * res.classCount + c]]);
+        }
+        auto it = std::ranges::find(signatures, signature);
+        next_block[u] = static_cast<uint32_t>(it - signatures.begin());
+        if (it == signatures.end()) {
+          signatures.emplace_back(std::move(signature));
+          representative_states.emplace_back(u);
+        }
+      }
+      block = std::move(next_block);
+      if (signatures.size() == block_count) {
+        break;
+      }
+      block_count = signatures.size();
+    }
+
+    res.stateCount = block_count;
+    res.s = block[1];
+    for (auto u : representative_states) {
+      for (size_t c = 0; c < res.classCount; ++c) {
+        res.table.emplace_back(block[table[u * res.classCount + c]]);
+      }
+      res.accepting.emplace_back(accepting[u]);
+    }
+    return res;
+  }
+
+  static constexpr auto kCounts = [] {
+    const auto compiled = Compile();
+    return std::pair{compiled.stateCount, compiled.classCount};
+  }();
+
+ public:
+  /**
+   * Smallest unsigned type that holds every state.
+   */
+  using StaticStateId = std::conditional_t<
+      kCounts.first <= 256, uint8_t,
+      std::conditional_t<kCounts.first <= 65536, uint16_t, uint32_t>>;
+
+  static constexpr StaticStateId kDeadState = 0;
+
+ private:
+  struct Tables {
+    std::array<uint8_t, 256> byteClasses{};
+    std::array<StaticStateId, kCounts.first * kCounts.second> table{};
+    std::array<bool, kCounts.first> accepting{};
+    StaticStateId s{};
+  };
+
+  static constexpr Tables kTables = [] {
+    const auto compiled = Compile();
+    auto res = Tables{};
+    res.byteClasses = compiled.byteClasses;
+    for (size_t i = 0; i < res.table.size(); ++i) {
+      res.table[i] = static_cast<StaticStateId>(compiled.table[i]);
+    }
+    for (size_t u = 0; u < res.accepting.size(); ++u) {
+      res.accepting[u] = compiled.accepting[u];
+    }
+    res.s = static_cast<StaticStateId>(compiled.s);
+    return res;
+  }();
+
+ public:
+  [[nodiscard]] static constexpr std::string_view GetPattern() {
+    return kPattern.View();
+  }
+
+  [[nodiscard]] static constexpr size_t StateCount() { return kCounts.first; }
+  [[nodiscard]] static constexpr size_t ClassCount() { return kCounts.second; }
+
+  [[nodiscard]] static constexpr StaticStateId GetS() { return kTables.s; }
+
+  [[nodiscard]] static constexpr StaticStateId Next(StaticStateId u,
+                                                    char byte) {
+    return kTables.table[u * ClassCount() +
+                         kTables.byteClasses[static_cast<uint8_t>(byte)]];
+  }
+
+  [[nodiscard]] static constexpr bool IsAccepting(StaticStateId u) {
+    return kTables.accepting[u];
+  }
+
+  /**
+   * Full match, whether the whole input is accepted.
+   */
+  [[nodiscard]] static constexpr bool Accepts(std::string_view input) {
+    auto u = GetS();
+    for (auto byte : input) {
+      u = Next(u, byte);
+      if (u == kDeadState) {
+        return false;
+      }
+    }
+    return IsAccepting(u);
+  }
+
+  /**
+   * Longest accepted prefix of input.
+   * @return Length of the prefix, or nullopt if no prefix (not even the empty
+   * one) is accepted.
+   */
+  [[nodiscard]] static constexpr std::optional<size_t> LongestMatch(
+      std::string_view input) {
+    auto res = std::optional<size_t>{};
+    auto u = GetS();
+    if (IsAccepting(u)) {
+      res = 0;
+    }
+    for (size_t i = 0; i < input.size(); ++i) {
+      u = Next(u, input[i]);
+      if (u == kDeadState) {
+        break;
+      }
+      if (IsAccepting(u)) {
+        res = i + 1;
+      }
+    }
+    return res;
+  }
+
+  /**
+   * Find all leftmost-longest, non-overlapping, non-empty matches.
+   * @param on_match Called as on_match(Match) for each match, in order.
+   */
+  template <typename OnMatch>
+  static constexpr void FindAll(std::string_view input, OnMatch &&on_match) {
+    size_t begin = 0;
+    while (begin < input.size()) {
+      auto len = LongestMatch(input.substr(begin));
+      if (len.has_value() && len.value() > 0) {
+        on_match(Match{begin, begin + len.value()});
+        begin += len.value();
+      } else {
+        ++begin;
+      }
+    }
+  }
+
+  /**
+   * Same as FindAll(input, on_match), collecting matches into a vector.
+   */
+  [[nodiscard]] static constexpr std::vector<Match> FindAll(
+      std::string_view input) {
+    auto res = std::vector<Match>{};
+    FindAll(input, [&res](const Match &match) { res.emplace_back(match); });
+    return res;
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_STATIC_DFA_HPP
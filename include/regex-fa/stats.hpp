@@ -0,0 +1,246 @@
+#ifndef REGEX_FA_STATS_HPP
+#define REGEX_FA_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Counters of construction. kPeak* keep the largest value seen, the others
+ * a sum.
+ */
+enum class StatCounter : uint8_t {
+  kSubsetsCreated,    // Dfa states found by subset construction
+  kSplits,            // blocks split by minimization
+  kRefinementRounds,  // Hopcroft splitters and Moore rounds
+  kBytesAllocated,    // by the scratch resource of ToDfa() and Minimize()
+  kPeakSubsets,       // largest subset table
+  kPeakBlocks,        // largest partition
+};
+
+inline constexpr size_t kStatCounterCount = 6;
+
+enum class StatPhase : uint8_t {
+  kRegexToNfa,
+  kToDfa,
+  kMinimize,
+};
+
+inline constexpr size_t kStatPhaseCount = 3;
+
+struct StatsSnapshot {
+  std::array<uint64_t, kStatCounterCount> counters{};
+  std::array<std::chrono::nanoseconds, kStatPhaseCount> phaseTimes{};
+
+  [[nodiscard]] uint64_t Get(StatCounter counter) const {
+    return counters[static_cast<size_t>(counter)];
+  }
+
+  [[nodiscard]] std::chrono::nanoseconds Get(StatPhase phase) const {
+    return phaseTimes[static_cast<size_t>(phase)];
+  }
+};
+
+/**
+ * Process-wide construction statistics, compiled in with REGEX_FA_STATS.
+ * Without it every call is empty and Read() returns zeros, so call sites
+ * need no #ifdef and cost nothing.
+ * Each thread writes its own counters with plain relaxed stores. Read()
+ * merges every live thread and those that have exited.
+ */
+class Stats {
+ public:
+  Stats() = delete;
+
+  static void Add([[maybe_unused]] StatCounter counter,
+                  [[maybe_unused]] uint64_t n = 1) {
+#ifdef REGEX_FA_STATS
+    auto &value = Local().counters[static_cast<size_t>(counter)];
+    value.store(value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+#endif
+  }
+
+  static void Max([[maybe_unused]] StatCounter counter,
+                  [[maybe_unused]] uint64_t n) {
+#ifdef REGEX_FA_STATS
+    auto &value = Local().counters[static_cast<size_t>(counter)];
+    if (value.load(std::memory_order_relaxed) < n) {
+      value.store(n, std::memory_order_relaxed);
+    }
+#endif
+  }
+
+  static void AddTime([[maybe_unused]] StatPhase phase,
+                      [[maybe_unused]] std::chrono::nanoseconds time) {
+#ifdef REGEX_FA_STATS
+    auto &value = Local().phaseNanos[static_cast<size_t>(phase)];
+    value.store(value.load(std::memory_order_relaxed) +
+                    static_cast<uint64_t>(time.count()),
+                std::memory_order_relaxed);
+#endif
+  }
+
+  [[nodiscard]] static StatsSnapshot Read() {
+    auto res = StatsSnapshot{};
+#ifdef REGEX_FA_STATS
+    auto &registry = GetRegistry();
+    auto lock = std::scoped_lock{registry.mutex};
+    res = registry.exited;
+    for (const auto *local : registry.live) {
+      Merge(res, *local);
+    }
+#endif
+    return res;
+  }
+
+  /**
+   * Zero every counter. Counts made concurrently may survive.
+   */
+  static void Reset() {
+#ifdef REGEX_FA_STATS
+    auto &registry = GetRegistry();
+    auto lock = std::scoped_lock{registry.mutex};
+    registry.exited = {};
+    for (auto *local : registry.live) {
+      for (auto &value : local->counters) {
+        value.store(0, std::memory_order_relaxed);
+      }
+      for (auto &value : local->phaseNanos) {
+        value.store(0, std::memory_order_relaxed);
+      }
+    }
+#endif
+  }
+
+#ifdef REGEX_FA_STATS
+ private:
+  struct LocalStats {
+    std::array<std::atomic<uint64_t>, kStatCounterCount> counters{};
+    std::array<std::atomic<uint64_t>, kStatPhaseCount> phaseNanos{};
+  };
+
+  struct Registry {
+    std::mutex mutex;
+    std::vector<LocalStats *> live;
+    StatsSnapshot exited;
+  };
+
+  static Registry &GetRegistry() {
+    // Never destroyed, threads may exit after static destruction.
+    static auto *registry = new Registry{};
+    return *registry;
+  }
+
+  static void Merge(StatsSnapshot &res, const LocalStats &local) {
+    for (size_t i = 0; i < kStatCounterCount; ++i) {
+      const auto value = local.counters[i].load(std::memory_order_relaxed);
+      const auto counter = static_cast<StatCounter>(i);
+      if (counter == StatCounter::kPeakSubsets ||
+          counter == StatCounter::kPeakBlocks) {
+        res.counters[i] = std::max(res.counters[i], value);
+      } else {
+        res.counters[i] += value;
+      }
+    }
+    for (size_t i = 0; i < kStatPhaseCount; ++i) {
+      res.phaseTimes[i] += std::chrono::nanoseconds{
+          local.phaseNanos[i].load(std::memory_order_relaxed)};
+    }
+  }
+
+  static LocalStats &Local() {
+    struct Registration {
+      LocalStats stats;
+
+      Registration() {
+        auto &registry = GetRegistry();
+        auto lock = std::scoped_lock{registry.mutex};
+        registry.live.emplace_back(&stats);
+      }
+
+      ~Registration() {
+        auto &registry = GetRegistry();
+        auto lock = std::scoped_lock{registry.mutex};
+        Merge(registry.exited, stats);
+        std::erase(registry.live, &stats);
+      }
+    };
+    thread_local auto registration = Registration{};
+    return registration.stats;
+  }
+#endif
+};
+
+/**
+ * Adds the wall time from construction to destruction to phase.
+ */
+class StatsTimer {
+ private:
+#ifdef REGEX_FA_STATS
+  StatPhase phase_;
+  std::chrono::steady_clock::time_point start_;
+#endif
+
+ public:
+  explicit StatsTimer([[maybe_unused]] StatPhase phase)
+#ifdef REGEX_FA_STATS
+      : phase_(phase), start_(std::chrono::steady_clock::now())
+#endif
+  {
+  }
+
+  StatsTimer(const StatsTimer &) = delete;
+  StatsTimer &operator=(const StatsTimer &) = delete;
+
+  ~StatsTimer() {
+#ifdef REGEX_FA_STATS
+    Stats::AddTime(phase_, std::chrono::steady_clock::now() - start_);
+#endif
+  }
+};
+
+/**
+ * Forwards to upstream, adding the bytes of every allocation to
+ * StatCounter::kBytesAllocated. Get() is upstream itself when stats are
+ * off, so nothing is forwarded.
+ */
+class StatsResource : public std::pmr::memory_resource {
+ private:
+  std::pmr::memory_resource *upstream_;
+
+ public:
+  explicit StatsResource(std::pmr::memory_resource &upstream)
+      : upstream_(&upstream) {}
+
+  [[nodiscard]] std::pmr::memory_resource &Get() {
+#ifdef REGEX_FA_STATS
+    return *this;
+#else
+    return *upstream_;
+#endif
+  }
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    Stats::Add(StatCounter::kBytesAllocated, bytes);
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    upstream_->deallocate(p, bytes, alignment);
+  }
+
+  [[nodiscard]] bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_STATS_HPP
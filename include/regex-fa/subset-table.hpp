@@ -0,0 +1,204 @@
+#ifndef REGEX_FA_SUBSET_TABLE_HPP
+#define REGEX_FA_SUBSET_TABLE_HPP
+
+#include <mutex>
+
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Interned subsets of dense Nfa states, numbered 0, 1, ... in insertion order.
+ * Each subset is a sorted list stored in one flat pool. Its hash is computed
+ * once on insertion and kept, so lookups and rehashing never rehash a subset.
+ */
+class SubsetTable {
+ public:
+  using SubsetId = uint32_t;
+
+ private:
+  static constexpr SubsetId kEmptySlot = std::numeric_limits<SubsetId>::max();
+
+  std::pmr::vector<uint32_t> pool_;    // all subsets, back to back
+  std::pmr::vector<uint32_t> first_;   // subset -> range in pool_
+  std::pmr::vector<uint64_t> hashes_;  // subset -> hash
+  std::pmr::vector<SubsetId> slots_;
+
+ public:
+  /**
+   * @param resource Memory of the table.
+   */
+  explicit SubsetTable(
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : pool_(resource),
+        first_(1, 0, resource),
+        hashes_(resource),
+        slots_(16, kEmptySlot, resource) {}
+
+  [[nodiscard]] static uint64_t Hash(std::span<const uint32_t> subset) {
+    auto res = uint64_t{subset.size()};
+    for (auto state : subset) {
+      res = (res ^ state) * 0x9e3779b97f4a7c15;
+      res ^= res >> 29;
+    }
+    return res;
+  }
+
+  [[nodiscard]] size_t Size() const { return hashes_.size(); }
+
+  /**
+   * Total number of states over all subsets.
+   */
+  [[nodiscard]] size_t PoolSize() const { return pool_.size(); }
+
+  /**
+   * Sorted states of subset id. Invalidated by Insert.
+   */
+  [[nodiscard]] std::span<const uint32_t> Get(SubsetId id) const {
+    return {pool_.data() + first_[id], pool_.data() + first_[id + 1]};
+  }
+
+  [[nodiscard]] uint64_t GetHash(SubsetId id) const { return hashes_[id]; }
+
+  /**
+   * @param subset Sorted states.
+   * @return Id of subset, or nullopt if it is not in the table.
+   */
+  [[nodiscard]] std::optional<SubsetId> Find(std::span<const uint32_t> subset,
+                                             uint64_t hash) const {
+    for (auto slot = hash & (slots_.size() - 1);;
+         slot = (slot + 1) & (slots_.size() - 1)) {
+      auto id = slots_[slot];
+      if (id == kEmptySlot) {
+        return std::nullopt;
+      }
+      if (hashes_[id] == hash && std::ranges::equal(Get(id), subset)) {
+        return id;
+      }
+    }
+  }
+
+  [[nodiscard]] std::optional<SubsetId> Find(
+      std::span<const uint32_t> subset) const {
+    return Find(subset, Hash(subset));
+  }
+
+  /**
+   * @param subset Sorted states.
+   * @return Id of subset, and whether it was newly inserted.
+   */
+  std::pair<SubsetId, bool> Insert(std::span<const uint32_t> subset,
+                                   uint64_t hash) {
+    auto slot = hash & (slots_.size() - 1);
+    for (; slots_[slot] != kEmptySlot; slot = (slot + 1) & (slots_.size() - 1)) {
+      auto id = slots_[slot];
+      if (hashes_[id] == hash && std::ranges::equal(Get(id), subset)) {
+        return {id, false};
+      }
+    }
+
+    const auto id = static_cast<SubsetId>(Size());
+    pool_.insert(pool_.end(), subset.begin(), subset.end());
+    first_.emplace_back(static_cast<uint32_t>(pool_.size()));
+    hashes_.emplace_back(hash);
+    slots_[slot] = id;
+
+    // Keep load factor under 1/2.
+    if (Size() * 2 > slots_.size()) {
+      Rehash(slots_.size() * 2);
+    }
+    return {id, true};
+  }
+
+  std::pair<SubsetId, bool> Insert(std::span<const uint32_t> subset) {
+    return Insert(subset, Hash(subset));
+  }
+
+  void Clear() {
+    pool_.clear();
+    first_.assign(1, 0);
+    hashes_.clear();
+    std::ranges::fill(slots_, kEmptySlot);
+  }
+
+ private:
+  void Rehash(size_t slot_count) {
+    slots_.assign(slot_count, kEmptySlot);
+    for (SubsetId id = 0; id < Size(); ++id) {
+      auto slot = hashes_[id] & (slot_count - 1);
+      while (slots_[slot] != kEmptySlot) {
+        slot = (slot + 1) & (slot_count - 1);
+      }
+      slots_[slot] = id;
+    }
+  }
+};
+
+/**
+ * SubsetTable split into shards by hash, each behind its own mutex, so
+ * threads can intern subsets concurrently. Every subset carries a Value.
+ */
+template <typename Value>
+class ConcurrentSubsetTable {
+ public:
+  struct Ref {
+    uint32_t shard{};
+    SubsetTable::SubsetId id{};
+  };
+
+ private:
+  struct Shard {
+    std::mutex mutex;
+    SubsetTable subsets;
+    std::vector<Value> values;
+  };
+
+  std::vector<Shard> shards_;
+
+ public:
+  explicit ConcurrentSubsetTable(size_t shard_count) : shards_(shard_count) {
+    assert(shard_count > 0);
+  }
+
+  /**
+   * Thread safe.
+   * @param subset Sorted states.
+   * @param make_value Called as make_value() for a new subset.
+   * @return Ref of subset, and whether it was newly inserted.
+   */
+  template <typename MakeValue>
+  std::pair<Ref, bool> Insert(std::span<const uint32_t> subset,
+                              MakeValue &&make_value) {
+    const auto hash = SubsetTable::Hash(subset);
+    const auto shard_id = static_cast<uint32_t>((hash >> 40) % shards_.size());
+    auto &shard = shards_[shard_id];
+
+    auto lock = std::lock_guard{shard.mutex};
+    auto [id, inserted] = shard.subsets.Insert(subset, hash);
+    if (inserted) {
+      shard.values.emplace_back(make_value());
+    }
+    return {Ref{shard_id, id}, inserted};
+  }
+
+  /**
+   * Thread safe.
+   */
+  void Get(Ref ref, std::vector<uint32_t> &res) {
+    auto &shard = shards_[ref.shard];
+    auto lock = std::lock_guard{shard.mutex};
+    const auto subset = shard.subsets.Get(ref.id);
+    res.assign(subset.begin(), subset.end());
+  }
+
+  /**
+   * Not thread safe.
+   */
+  [[nodiscard]] Value &GetValue(Ref ref) {
+    return shards_[ref.shard].values[ref.id];
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_SUBSET_TABLE_HPP
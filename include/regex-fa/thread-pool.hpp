@@ -0,0 +1,171 @@
+#ifndef REGEX_FA_THREAD_POOL_HPP
+#define REGEX_FA_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "fa-include.hpp"
+
+namespace regex_fa {
+
+/**
+ * Fixed set of threads running ParallelFor jobs with work stealing.
+ * Every thread has its own deque of index ranges. It pops ranges from the
+ * front of its own deque and, once that is empty, steals from the back of
+ * the others. The calling thread works as thread 0.
+ */
+class ThreadPool {
+ private:
+  using Range = std::pair<size_t, size_t>;
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+  size_t size_;
+  std::unique_ptr<Worker[]> workers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  std::function<void(size_t, size_t)> job_;
+  size_t generation_{0};
+  bool stop_{false};
+  std::atomic<size_t> remaining_{0};
+
+ public:
+  /**
+   * @param thread_count Threads in total, the caller included. 0 means
+   * std::thread::hardware_concurrency().
+   */
+  explicit ThreadPool(size_t thread_count)
+      : size_(thread_count != 0
+                  ? thread_count
+                  : std::max<size_t>(1, std::thread::hardware_concurrency())),
+        workers_(std::make_unique<Worker[]>(size_)) {
+    for (size_t i = 1; i < size_; ++i) {
+      threads_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      auto lock = std::lock_guard{mutex_};
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  [[nodiscard]] size_t Size() const { return size_; }
+
+  /**
+   * Call f(i, thread) for every i in [0, count), and wait for all of them.
+   * thread < Size() identifies the calling thread, for per-thread scratch.
+   * @param grain Indices per stolen range.
+   */
+  template <typename F>
+  void ParallelFor(size_t count, size_t grain, F &&f) {
+    if (count == 0) {
+      return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    if (size_ == 1 || count <= grain) {
+      for (size_t i = 0; i < count; ++i) {
+        f(i, size_t{0});
+      }
+      return;
+    }
+
+    {
+      auto lock = std::lock_guard{mutex_};
+      job_ = [&f](size_t i, size_t thread) { f(i, thread); };
+      // Set before the first push, a worker still leaving the previous job
+      // may already take a range.
+      remaining_ = (count + grain - 1) / grain;
+      size_t range_count = 0;
+      for (size_t begin = 0; begin < count; begin += grain, ++range_count) {
+        auto &worker = workers_[range_count % size_];
+        auto worker_lock = std::lock_guard{worker.mutex};
+        worker.ranges.emplace_back(begin, std::min(count, begin + grain));
+      }
+      ++generation_;
+    }
+    start_cv_.notify_all();
+
+    while (RunOne(0)) {
+    }
+
+    auto lock = std::unique_lock{mutex_};
+    done_cv_.wait(lock, [this] { return remaining_ == 0; });
+    job_ = nullptr;
+  }
+
+ private:
+  void WorkerLoop(size_t thread) {
+    size_t seen_generation = 0;
+    while (true) {
+      {
+        auto lock = std::unique_lock{mutex_};
+        start_cv_.wait(lock, [this, seen_generation] {
+          return stop_ || generation_ != seen_generation;
+        });
+        if (stop_) {
+          return;
+        }
+        seen_generation = generation_;
+      }
+      while (RunOne(thread)) {
+      }
+    }
+  }
+
+  /**
+   * Run one range, own ranges first, then stolen ones.
+   * @return False if there was nothing left to run.
+   */
+  bool RunOne(size_t thread) {
+    auto range = std::optional<Range>{};
+    for (size_t k = 0; k < size_ && !range.has_value(); ++k) {
+      auto &worker = workers_[(thread + k) % size_];
+      auto lock = std::lock_guard{worker.mutex};
+      if (worker.ranges.empty()) {
+        continue;
+      }
+      if (k == 0) {
+        range = worker.ranges.front();
+        worker.ranges.pop_front();
+      } else {
+        range = worker.ranges.back();
+        worker.ranges.pop_back();
+      }
+    }
+    if (!range.has_value()) {
+      return false;
+    }
+
+    for (auto i = range->first; i < range->second; ++i) {
+      job_(i, thread);
+    }
+    if (remaining_.fetch_sub(1) == 1) {
+      auto lock = std::lock_guard{mutex_};
+      done_cv_.notify_all();
+    }
+    return true;
+  }
+};
+
+}  // namespace regex_fa
+
+#endif  // REGEX_FA_THREAD_POOL_HPP
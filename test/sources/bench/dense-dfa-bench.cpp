@@ -0,0 +1,83 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+/**
+ * (a|b)*abb over random a/b input.
+ */
+[[nodiscard]] Dfa AbbDfa() {
+  auto dfa_table = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 0}}},
+      {1, {{"a", 1}, {"b", 2}}},
+      {2, {{"a", 1}, {"b", 3}}},
+      {3, {{"a", 1}, {"b", 0}}},
+  };
+  return Dfa{dfa_table, 0, {3}};
+}
+
+[[nodiscard]] std::string RandomInput(size_t size) {
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<int>{0, 1};
+  auto res = std::string(size, 'a');
+  for (auto &c : res) {
+    c = u(e) ? 'a' : 'b';
+  }
+  return res;
+}
+
+template <typename F>
+[[nodiscard]] double MegabytesPerSecond(size_t size, F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return static_cast<double>(size) / 1e6 / seconds;
+}
+
+}  // namespace
+
+TEST(DenseDfaBench, Throughput) {
+  constexpr size_t kSize = 16 << 20;
+  const auto input = RandomInput(kSize);
+  const auto dfa = AbbDfa();
+  const auto dense = DenseDfa{dfa};
+
+  // Walking Dfa::DfaTable, two hash lookups per byte.
+  auto table_accepts = false;
+  const auto table_speed = MegabytesPerSecond(kSize, [&] {
+    auto u = dfa.GetS();
+    const auto &dfa_table = dfa.GetDfaTable();
+    auto terminal = Terminal(1, ' ');
+    for (auto c : input) {
+      terminal[0] = c;
+      u = dfa_table.at(u).at(terminal);
+    }
+    table_accepts = dfa.GetF().contains(u);
+  });
+
+  auto dense_accepts = false;
+  const auto dense_speed = MegabytesPerSecond(
+      kSize, [&] { dense_accepts = dense.Accepts(input); });
+
+  auto match_count = size_t{0};
+  const auto find_all_speed = MegabytesPerSecond(kSize, [&] {
+    dense.FindAll(std::string_view{input},
+                  [&match_count](const Match &) { ++match_count; });
+  });
+
+  ASSERT_EQ(table_accepts, dense_accepts);
+  GTEST_LOG_(INFO) << "DfaTable walk: " << table_speed << " MB/s";
+  GTEST_LOG_(INFO) << "DenseDfa::Accepts: " << dense_speed << " MB/s";
+  GTEST_LOG_(INFO) << "DenseDfa::FindAll: " << find_all_speed << " MB/s, "
+                   << match_count << " matches";
+}
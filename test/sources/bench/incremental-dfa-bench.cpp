@@ -0,0 +1,58 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+
+#include "regex-fa/incremental-dfa.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+template <typename F>
+[[nodiscard]] double Milliseconds(F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+TEST(IncrementalDfaBench, UpdateLatency) {
+  // Keyword rules, as in a rule set that changes a few rules at a time.
+  auto patterns = std::vector<std::string>{};
+  for (size_t i = 0; i < 40; ++i) {
+    patterns.emplace_back("[a-z]*" + std::string(1, 'a' + i % 26) +
+                          std::to_string(i * 7919) + "[0-9]*");
+  }
+
+  auto dfa = IncrementalDfa{};
+  for (size_t i = 0; i + 1 < patterns.size(); ++i) {
+    dfa.Add(patterns[i]);
+  }
+
+  auto nfas = std::vector<Nfa>{};
+  for (const auto &pattern : patterns) {
+    nfas.emplace_back(RegexToNfa(pattern));
+  }
+  auto rebuilt = std::optional<Dfa>{};
+  const auto rebuild_ms = Milliseconds(
+      [&] { rebuilt.emplace(Nfa::Union(nfas).ToDfa().Minimize()); });
+
+  auto pattern = PatternId{};
+  const auto add_ms = Milliseconds([&] { pattern = dfa.Add(patterns.back()); });
+  ASSERT_EQ(dfa.GetDfa().GetDfaTable().size(), rebuilt->GetDfaTable().size());
+
+  const auto remove_ms = Milliseconds([&] { dfa.Remove(pattern); });
+
+  GTEST_LOG_(INFO) << patterns.size() << " patterns, "
+                   << rebuilt->GetDfaTable().size() << " states";
+  GTEST_LOG_(INFO) << "Rebuild: " << rebuild_ms << " ms";
+  GTEST_LOG_(INFO) << "IncrementalDfa::Add: " << add_ms << " ms";
+  GTEST_LOG_(INFO) << "IncrementalDfa::Remove: " << remove_ms << " ms";
+}
@@ -0,0 +1,48 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+template <typename F>
+[[nodiscard]] double Seconds(F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace
+
+TEST(MemoryResourceBench, ToDfaAndMinimize) {
+  // 4096 states, many small subsets and splits.
+  const auto nfa = RegexToNfa("(a|b)*a(a|b){11}");
+  const auto expected = nfa.ToDfa().Minimize();
+
+  auto Compile = [&](std::string_view name,
+                     std::pmr::memory_resource &resource) {
+    auto res = Dfa{{}, 0, {}};
+    const auto seconds =
+        Seconds([&] { res = nfa.ToDfa(resource).Minimize(resource); });
+    ASSERT_EQ(res.GetDfaTable(), expected.GetDfaTable());
+    GTEST_LOG_(INFO) << name << ": " << seconds << " s";
+  };
+
+  Compile("new_delete_resource", *std::pmr::new_delete_resource());
+  {
+    auto arena = std::pmr::monotonic_buffer_resource{};
+    Compile("monotonic_buffer_resource", arena);
+  }
+  {
+    auto pool = std::pmr::unsynchronized_pool_resource{};
+    Compile("unsynchronized_pool_resource", pool);
+  }
+}
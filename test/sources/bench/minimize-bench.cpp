@@ -0,0 +1,30 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+TEST(MinimizeBench, ThreadScaling) {
+  // 32768 states, already minimal, so Moore needs every round.
+  const auto dfa = RegexToNfa("(a|b)*a(a|b){14}").ToDfa();
+  const auto expected = dfa.Minimize();
+
+  for (size_t thread_count : {1, 2, 4, 8, 16}) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto res = dfa.Minimize(thread_count);
+    const auto seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+    ASSERT_EQ(res.GetDfaTable(), expected.GetDfaTable());
+    GTEST_LOG_(INFO) << "Minimize(" << thread_count << "): "
+                     << dfa.GetDfaTable().size() << " -> "
+                     << res.GetDfaTable().size() << " states in " << seconds
+                     << " s";
+  }
+}
@@ -0,0 +1,95 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/multi-stream-dfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+/**
+ * Short records, 16 to 64 bytes of hex digits and dashes.
+ */
+[[nodiscard]] std::vector<std::string> RandomRecords(size_t count) {
+  auto e = std::default_random_engine{0};
+  auto len = std::uniform_int_distribution<size_t>{16, 64};
+  auto u = std::uniform_int_distribution<int>{0, 16};
+  auto res = std::vector<std::string>{};
+  for (size_t i = 0; i < count; ++i) {
+    auto record = std::string(len(e), '0');
+    for (auto &c : record) {
+      c = "0123456789abcdef-"[u(e)];
+    }
+    res.emplace_back(std::move(record));
+  }
+  return res;
+}
+
+template <typename F>
+[[nodiscard]] double MegabytesPerSecond(size_t size, F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return static_cast<double>(size) / 1e6 / seconds;
+}
+
+}  // namespace
+
+TEST(MultiStreamBench, ShortRecords) {
+  const auto records = RandomRecords(1 << 18);
+  const auto inputs =
+      std::vector<std::string_view>{records.begin(), records.end()};
+  auto size = size_t{0};
+  for (auto input : inputs) {
+    size += input.size();
+  }
+
+  // Few states, fits the shuffle kernels.
+  const auto dense =
+      DenseDfa{RegexToNfa("([0-9a-f]|-)*-[0-9a-f]{4}").ToDfa().Minimize()};
+
+  auto expected = std::vector<uint8_t>(inputs.size());
+  const auto dense_speed = MegabytesPerSecond(size, [&] {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      expected[i] = dense.Accepts(inputs[i]);
+    }
+  });
+  GTEST_LOG_(INFO) << "DenseDfa::Accepts: " << dense_speed << " MB/s, "
+                   << dense.StateCount() << " states";
+
+  const auto dfa =
+      MultiStreamDfa{dense.View(), MultiStreamDfa::Kernel::kInterleaved};
+  auto results = std::vector<uint8_t>(inputs.size());
+  auto Interleaved = [&]<size_t kLanes>() {
+    const auto speed = MegabytesPerSecond(size, [&] {
+      dfa.AcceptsInterleaved<kLanes>(std::span{inputs}, std::span{results});
+    });
+    ASSERT_EQ(results, expected);
+    GTEST_LOG_(INFO) << "Interleaved<" << kLanes << ">: " << speed << " MB/s";
+  };
+  Interleaved.operator()<4>();
+  Interleaved.operator()<8>();
+  Interleaved.operator()<16>();
+
+  for (auto kernel :
+       {MultiStreamDfa::Kernel::kSsse3, MultiStreamDfa::Kernel::kAvx2}) {
+    if (!MultiStreamDfa::IsSupported(kernel)) {
+      continue;
+    }
+    const auto shuffle = MultiStreamDfa{dense.View(), kernel};
+    const auto speed = MegabytesPerSecond(
+        size, [&] { shuffle.Accepts(std::span{inputs}, std::span{results}); });
+    ASSERT_EQ(results, expected);
+    GTEST_LOG_(INFO) << (kernel == MultiStreamDfa::Kernel::kSsse3 ? "Ssse3"
+                                                                  : "Avx2")
+                     << ": " << speed << " MB/s";
+  }
+}
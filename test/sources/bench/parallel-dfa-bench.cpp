@@ -0,0 +1,56 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/parallel-dfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+[[nodiscard]] std::string RandomLog(size_t size) {
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<int>{0, 39};
+  auto res = std::string(size, ' ');
+  for (auto &c : res) {
+    c = "abcdefghijklmnopqrstuvwxyz0123456789 :-\n"[u(e)];
+  }
+  return res;
+}
+
+void ThreadScaling(std::string_view pattern, std::string_view text,
+                   ParallelDfa::Options options) {
+  const auto dfa = DenseDfa{RegexToNfa(pattern).ToDfa().Minimize()};
+  const auto expected = dfa.Accepts(text);
+
+  for (size_t thread_count : {1, 2, 4, 8, 16}) {
+    auto parallel = ParallelDfa{dfa.View(), thread_count, options};
+    const auto start = std::chrono::steady_clock::now();
+    const auto res = parallel.Accepts(text);
+    const auto seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+    ASSERT_EQ(res, expected);
+    GTEST_LOG_(INFO) << pattern << ", " << dfa.StateCount() << " states, "
+                     << thread_count << " threads: "
+                     << static_cast<double>(text.size()) / 1e6 / seconds
+                     << " MB/s";
+  }
+}
+
+}  // namespace
+
+TEST(ParallelDfaBench, ThreadScaling) {
+  const auto text = RandomLog(size_t{1} << 24);
+
+  // Few states, every chunk runs from all of them.
+  ThreadScaling(".*error:[0-9]+", text, {});
+  // Too many states to enumerate, chunks speculate.
+  ThreadScaling(".*[a-f](.|\\n){6}x", text, {.maxEnumeratedStates = 0});
+}
@@ -0,0 +1,55 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+#include <random>
+
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+/**
+ * Rule-file style patterns: literals, classes, alternations, repeats.
+ */
+[[nodiscard]] std::vector<std::string> RandomPatterns(size_t count) {
+  auto e = std::default_random_engine{0};
+  auto word = [&e] {
+    auto u = std::uniform_int_distribution<int>{'a', 'z'};
+    auto len = std::uniform_int_distribution<int>{3, 8}(e);
+    auto res = std::string{};
+    for (int i = 0; i < len; ++i) {
+      res.push_back(static_cast<char>(u(e)));
+    }
+    return res;
+  };
+
+  auto res = std::vector<std::string>{};
+  for (size_t i = 0; i < count; ++i) {
+    res.emplace_back(word() + "(" + word() + "|" + word() + ")*[0-9]{1,4}" +
+                     word() + "[a-f]+\\.?");
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST(RegexBench, CompilePatternSet) {
+  constexpr size_t kCount = 10000;
+  const auto patterns = RandomPatterns(kCount);
+
+  auto states = size_t{0};
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto &pattern : patterns) {
+    states += RegexToNfa(pattern).GetNfaTable().size();
+  }
+  const auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+  GTEST_LOG_(INFO) << "RegexToNfa: " << kCount << " patterns, " << states
+                   << " states in " << seconds << " s, "
+                   << static_cast<double>(kCount) / seconds << " patterns/s";
+}
@@ -0,0 +1,65 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <chrono>
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+#include "regex-fa/static-dfa.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+[[nodiscard]] std::string RandomInput(size_t size) {
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<int>{0, 1};
+  auto res = std::string(size, 'a');
+  for (auto &c : res) {
+    c = u(e) ? 'a' : 'b';
+  }
+  return res;
+}
+
+template <typename F>
+[[nodiscard]] double MegabytesPerSecond(size_t size, F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return static_cast<double>(size) / 1e6 / seconds;
+}
+
+}  // namespace
+
+TEST(StaticDfaBench, Throughput) {
+  using Abb = StaticDfa<"(a|b)*abb">;
+  constexpr size_t kSize = 16 << 20;
+  const auto input = RandomInput(kSize);
+
+  // Runtime construction, paid by DenseDfa at startup and not at all by
+  // StaticDfa.
+  auto dense = std::optional<DenseDfa>{};
+  const auto build_start = std::chrono::steady_clock::now();
+  dense.emplace(RegexToNfa(Abb::GetPattern()).ToDfa().Minimize());
+  const auto build_us = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - build_start)
+                            .count();
+
+  auto dense_accepts = false;
+  const auto dense_speed = MegabytesPerSecond(
+      kSize, [&] { dense_accepts = dense->Accepts(input); });
+
+  auto static_accepts = false;
+  const auto static_speed = MegabytesPerSecond(
+      kSize, [&] { static_accepts = Abb::Accepts(input); });
+
+  ASSERT_EQ(static_accepts, dense_accepts);
+  GTEST_LOG_(INFO) << "DenseDfa build: " << build_us << " us";
+  GTEST_LOG_(INFO) << "DenseDfa::Accepts: " << dense_speed << " MB/s";
+  GTEST_LOG_(INFO) << "StaticDfa::Accepts: " << static_speed << " MB/s";
+}
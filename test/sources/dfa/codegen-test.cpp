@@ -0,0 +1,73 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include "regex-fa/codegen.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+/**
+ * (a|b)*abb, states in bfs order.
+ */
+[[nodiscard]] Dfa AbbDfa() {
+  auto dfa_table = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 0}}},
+      {1, {{"a", 1}, {"b", 2}}},
+      {2, {{"a", 1}, {"b", 3}}},
+      {3, {{"a", 1}, {"b", 0}}},
+  };
+  return Dfa{dfa_table, 0, {3}};
+}
+
+}  // namespace
+
+TEST(Codegen, Layout) {
+  EXPECT_EQ(Codegen(AbbDfa(), {}).GetLayout(),
+            (std::vector<StateId>{0, 1, 2, 3}));
+
+  // a c* | b c*, 2 is hotter than 1, the start state always comes first.
+  auto dfa_table = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 2}}},
+      {1, {{"c", 1}}},
+      {2, {{"c", 2}}},
+  };
+  auto options = CodegenOptions{};
+  options.sample = "accbcccccbccc";
+  EXPECT_EQ(Codegen(Dfa{dfa_table, 0, {1, 2}}, options).GetLayout(),
+            (std::vector<StateId>{0, 2, 1}));
+}
+
+TEST(Codegen, Generate) {
+  auto options = CodegenOptions{};
+  options.name = "Abb";
+  options.nameSpace = "generated";
+  const auto code = Codegen(AbbDfa(), options).Generate();
+
+  EXPECT_NE(code.find("namespace generated {"), std::string::npos);
+  EXPECT_NE(code.find("inline bool AbbAccepts(std::string_view input)"),
+            std::string::npos);
+  EXPECT_NE(code.find("inline std::optional<size_t> AbbLongestMatch("),
+            std::string::npos);
+  for (auto label : {"\ns0:\n", "\ns1:\n", "\ns2:\n", "\ns3:\n"}) {
+    EXPECT_NE(code.find(label), std::string::npos) << label;
+  }
+  // Only state 3 accepts.
+  EXPECT_EQ(code.find("return true;"), code.rfind("return true;"));
+  EXPECT_EQ(code.find("res = i;"), code.rfind("res = i;"));
+}
+
+TEST(Codegen, DefaultIsLargestGroup) {
+  const auto dfa = RegexToNfa("[^x]*x").ToDfa().Minimize().ReorderStates();
+  const auto code = Codegen(dfa, {}).Generate();
+
+  // s0 loops on every byte but 'x', which is the only case label.
+  EXPECT_NE(code.find("    case 120:\n      goto s1;\n    default:\n"
+                      "      goto s0;\n"),
+            std::string::npos)
+      << code;
+  EXPECT_EQ(code.find("case 0:"), std::string::npos);
+}
@@ -0,0 +1,106 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <cstdio>
+#include <cstring>
+
+#include "regex-fa/dense-dfa-file.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+[[nodiscard]] DenseDfa EmailDfa() {
+  return DenseDfa{RegexToNfa("[a-z]+@[a-z]+\\.(com|org)").ToDfa().Minimize()};
+}
+
+/**
+ * Copy of bytes in 8-byte aligned storage.
+ */
+[[nodiscard]] std::vector<uint64_t> Aligned(std::span<const std::byte> bytes) {
+  auto res = std::vector<uint64_t>((bytes.size() + 7) / 8);
+  std::memcpy(res.data(), bytes.data(), bytes.size());
+  return res;
+}
+
+[[nodiscard]] std::span<const std::byte> AsBytes(
+    const std::vector<uint64_t> &words, size_t size) {
+  return std::as_bytes(std::span{words}).first(size);
+}
+
+}  // namespace
+
+TEST(DenseDfaFile, RoundTrip) {
+  const auto dense = EmailDfa();
+  const auto bytes = SerializeDenseDfa(dense);
+  ASSERT_EQ(bytes.size() % kDenseDfaFileAlignment, 0);
+
+  const auto words = Aligned(bytes);
+  const auto image = DenseDfaImage{AsBytes(words, bytes.size()), true};
+  ASSERT_EQ(image.StateCount(), dense.StateCount());
+  ASSERT_EQ(image.SymbolCount(), dense.SymbolCount());
+  ASSERT_EQ(image.View().ClassCount(), dense.ClassCount());
+  ASSERT_TRUE(std::ranges::equal(image.View().GetTable(), dense.GetTable()));
+  for (SymbolId t = 0; t < dense.SymbolCount(); ++t) {
+    ASSERT_EQ(image.GetTerminal(t), dense.GetSymbolTable().GetTerminal(t));
+  }
+  for (DenseDfa::DenseStateId u = 0; u < dense.StateCount(); ++u) {
+    ASSERT_EQ(image.GetStateId(u), dense.GetStateId(u));
+    ASSERT_EQ(image.View().IsAccepting(u), dense.IsAccepting(u));
+  }
+
+  for (auto input : {"ab@cd.com", "ab@cd.co", "x@y.org", "@y.org", ""}) {
+    ASSERT_EQ(image.View().Accepts(input), dense.Accepts(input)) << input;
+  }
+  const auto text = std::string_view{"mail a@b.com or cc@dd.org, not e@f.net"};
+  ASSERT_EQ(image.View().FindAll(text), dense.FindAll(text));
+}
+
+TEST(DenseDfaFile, Corrupted) {
+  const auto bytes = SerializeDenseDfa(EmailDfa());
+  auto Load = [](std::vector<std::byte> file, bool verify) {
+    const auto words = Aligned(file);
+    return DenseDfaImage{AsBytes(words, file.size()), verify};
+  };
+
+  // Flip one transition: only the checksum notices.
+  auto header = DenseDfaFileHeader{};
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  auto flipped = bytes;
+  flipped[header.table.offset] ^= std::byte{1};
+  ASSERT_THROW((void)Load(flipped, true), DenseDfaFileError);
+  ASSERT_NO_THROW((void)Load(flipped, false));
+
+  auto bad_magic = bytes;
+  bad_magic[0] = std::byte{'X'};
+  ASSERT_THROW((void)Load(bad_magic, false), DenseDfaFileError);
+
+  auto truncated = bytes;
+  truncated.resize(bytes.size() - kDenseDfaFileAlignment);
+  ASSERT_THROW((void)Load(truncated, false), DenseDfaFileError);
+
+  auto bad_version = bytes;
+  auto version = kDenseDfaFileVersion + 1;
+  std::memcpy(bad_version.data() + offsetof(DenseDfaFileHeader, version),
+              &version, sizeof(version));
+  ASSERT_THROW((void)Load(bad_version, false), DenseDfaFileError);
+}
+
+TEST(MappedDfa, SaveAndMap) {
+  const auto dense = EmailDfa();
+  const auto path = ::testing::TempDir() + "regex-fa-mapped-dfa.bin";
+  SaveDenseDfa(dense, path);
+
+  auto mapped = MappedDfa{path};
+  ASSERT_EQ(mapped.View().StateCount(), dense.StateCount());
+  ASSERT_TRUE(mapped.View().Accepts("abc@example.org"));
+  ASSERT_FALSE(mapped.View().Accepts("abc@example.net"));
+
+  auto moved = std::move(mapped);
+  ASSERT_TRUE(moved.View().Accepts("abc@example.com"));
+  std::remove(path.c_str());
+
+  ASSERT_THROW(MappedDfa{path}, DenseDfaFileError);
+}
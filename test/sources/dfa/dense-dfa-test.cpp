@@ -0,0 +1,164 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+TEST(SymbolTable, Intern) {
+  auto symbols = SymbolTable{Terminals{"b", "a"}};
+  ASSERT_EQ(symbols.Find("a"), 0);
+  ASSERT_EQ(symbols.Find("b"), 1);
+  ASSERT_EQ(symbols.Find("c"), SymbolTable::kNoSymbol);
+
+  ASSERT_EQ(symbols.Intern("c"), 2);
+  ASSERT_EQ(symbols.Intern("a"), 0);
+  ASSERT_EQ(symbols.GetTerminal(2), "c");
+  ASSERT_EQ(symbols.Size(), 3);
+}
+
+TEST(DenseDfa, FromDfa) {
+  auto dfa_table = Dfa::DfaTable{
+      {1, {{"a", 2}, {"b", 5}}},
+      {2, {{"a", 2}}},
+      {5, {}},
+  };
+  auto dense = DenseDfa{Dfa{dfa_table, 2, {5}}};
+
+  ASSERT_EQ(dense.StateCount(), 3);
+  ASSERT_EQ(dense.SymbolCount(), 2);
+  ASSERT_EQ(dense.GetStateId(DenseDfa::GetS()), 2);
+  ASSERT_EQ(dense.GetStateId(1), 1);
+  ASSERT_EQ(dense.GetStateId(2), 5);
+
+  const auto a = dense.GetSymbolTable().Find("a");
+  const auto b = dense.GetSymbolTable().Find("b");
+  ASSERT_EQ(dense.Next(0, a), 0);
+  ASSERT_EQ(dense.Next(0, b), DenseDfa::kDeadState);
+  ASSERT_EQ(dense.Next(1, a), 0);
+  ASSERT_EQ(dense.Next(1, b), 2);
+  ASSERT_FALSE(dense.IsAccepting(0));
+  ASSERT_TRUE(dense.IsAccepting(2));
+}
+
+TEST(DenseDfa, FromFlatDfa) {
+  auto dfa_table = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 0}}},
+      {1, {{"a", 1}, {"b", 0}}},
+  };
+  auto dfa = Dfa{dfa_table, 0, {1}};
+  auto dense = DenseDfa{dfa.ToFlatDfa()};
+
+  ASSERT_EQ(Dfa{dense.ToFlatDfa()}.GetDfaTable(), dfa_table);
+  ASSERT_TRUE(dense.IsAccepting(1));
+}
+
+TEST(SymbolClasses, Refine) {
+  auto classes = SymbolClasses{5};
+  auto edges = std::vector<SymbolClasses::Edge>{{7, 0}, {7, 1}, {8, 2}};
+  classes.Refine(edges);
+  // {0, 1} -> 7, {2} -> 8, {3, 4} -> nothing.
+  ASSERT_EQ(classes.GetClasses(), (std::vector<ClassId>{0, 0, 1, 2, 2}));
+
+  edges = {{7, 1}, {7, 3}, {7, 4}};
+  classes.Refine(edges);
+  ASSERT_EQ(classes.GetClasses(), (std::vector<ClassId>{0, 1, 2, 3, 3}));
+  ASSERT_EQ(classes.Size(), 4);
+}
+
+TEST(DenseDfa, ByteClasses) {
+  const auto dfa = RegexToNfa("[a-z]+@[a-z]+\\.(com|org)").ToDfa().Minimize();
+  const auto dense = DenseDfa{dfa};
+
+  // Every terminal is a column of the full table, classes are far fewer.
+  ASSERT_EQ(dense.SymbolCount(), 28);
+  ASSERT_LT(dense.ClassCount(), 10);
+  ASSERT_EQ(dense.GetTable().size(), dense.StateCount() * dense.ClassCount());
+
+  // Bytes without a terminal share a class that goes nowhere.
+  const auto view = dense.View();
+  ASSERT_EQ(view.GetClass(std::byte{'#'}), view.GetClass(std::byte{'A'}));
+  for (DenseDfa::DenseStateId u = 0; u < dense.StateCount(); ++u) {
+    ASSERT_EQ(dense.Next(u, std::byte{'#'}), DenseDfa::kDeadState);
+    ASSERT_EQ(dense.Next(u, dense.GetSymbolTable().Find("x")),
+              dense.Next(u, std::byte{'x'}));
+  }
+
+  ASSERT_EQ(Dfa{dense.ToFlatDfa()}.Minimize().ReorderStates().GetDfaTable(),
+            dfa.ReorderStates().GetDfaTable());
+  ASSERT_TRUE(dense.Accepts("ab@cd.org"));
+  ASSERT_FALSE(dense.Accepts("ab@cd.net"));
+}
+
+TEST(DfaTerminalClasses, DfaAndNfa) {
+  // a and b always go together, c does not.
+  const auto dfa = Dfa{Dfa::DfaTable{
+                           {0, {{"a", 1}, {"b", 1}, {"c", 2}}},
+                           {1, {{"a", 1}, {"b", 1}}},
+                           {2, {{"c", 0}}},
+                       },
+                       0,
+                       {2}};
+  ASSERT_EQ(dfa.GetTerminalClasses(),
+            (TerminalClasses{{"a", "b"}, {"c"}}));
+
+  const auto nfa = Nfa{Nfa::NfaTable{
+                           {0, {{"a", {0, 1}}, {"b", {0, 1}}, {"c", {0}}}},
+                           {1, {{kEpsilon, {0}}, {"d", {1}}, {"e", {1}}}},
+                       },
+                       0,
+                       {1}};
+  ASSERT_EQ(nfa.GetTerminalClasses(),
+            (TerminalClasses{{"a", "b"}, {"c"}, {"d", "e"}}));
+}
+
+/**
+ * ab*c, states: 0 -a-> 1 -b-> 1 -c-> 2.
+ */
+[[nodiscard]] DenseDfa AbStarC() {
+  auto dfa_table = Dfa::DfaTable{
+      {0, {{"a", 1}}},
+      {1, {{"b", 1}, {"c", 2}}},
+      {2, {}},
+  };
+  return DenseDfa{Dfa{dfa_table, 0, {2}}};
+}
+
+TEST(DenseDfaMatch, Accepts) {
+  const auto dense = AbStarC();
+  ASSERT_TRUE(dense.Accepts("ac"));
+  ASSERT_TRUE(dense.Accepts("abbbc"));
+  ASSERT_FALSE(dense.Accepts(""));
+  ASSERT_FALSE(dense.Accepts("abb"));
+  ASSERT_FALSE(dense.Accepts("abcc"));
+  ASSERT_FALSE(dense.Accepts("axc"));
+
+  const auto bytes = std::array{std::byte{'a'}, std::byte{'c'}};
+  ASSERT_TRUE(dense.Accepts(std::span<const std::byte>{bytes}));
+}
+
+TEST(DenseDfaMatch, LongestMatch) {
+  const auto dense = AbStarC();
+  ASSERT_EQ(dense.LongestMatch("abcabc"), 3);
+  ASSERT_EQ(dense.LongestMatch("abb"), std::nullopt);
+
+  auto dfa_table = Dfa::DfaTable{{0, {{"a", 0}}}};
+  const auto a_star = DenseDfa{Dfa{dfa_table, 0, {0}}};
+  ASSERT_EQ(a_star.LongestMatch("aab"), 2);
+  ASSERT_EQ(a_star.LongestMatch("b"), 0);
+}
+
+TEST(DenseDfaMatch, FindAll) {
+  const auto dense = AbStarC();
+  ASSERT_EQ(dense.FindAll("xacabbcaabc!"),
+            (std::vector<Match>{{1, 3}, {3, 7}, {8, 11}}));
+  ASSERT_TRUE(dense.FindAll("abab").empty());
+
+  auto count = size_t{0};
+  dense.FindAll(std::string_view{"acac"},
+                [&count](const Match &) { ++count; });
+  ASSERT_EQ(count, 2);
+}
@@ -1,11 +1,35 @@
 // clang-format off
 #include "test.h"
 // clang-format on
+#include <random>
+
 #include "regex-fa/dfa.hpp"
 
 using namespace regex_fa;
 
-TEST(DfaHopcroftOne, SuccessCase1) {
+TEST(RefinablePartition, SplitMarked) {
+  auto partition = RefinablePartition{{0, 0, 0, 1}, 2};
+  ASSERT_EQ(partition.BlockCount(), 2);
+
+  partition.Mark(1);
+  partition.Mark(1);
+  partition.Mark(3);
+
+  auto splits = std::vector<std::pair<RefinablePartition::BlockId,
+                                      RefinablePartition::BlockId>>{};
+  partition.SplitMarked([&splits](auto old_id, auto new_id) {
+    splits.emplace_back(old_id, new_id);
+  });
+
+  // Block 1 is wholly marked, block 0 splits off the smaller half {1}.
+  ASSERT_EQ(splits, (decltype(splits){{0, 2}}));
+  ASSERT_EQ(partition.BlockCount(), 3);
+  ASSERT_EQ(partition.BlockOf(1), 2);
+  ASSERT_EQ(partition.BlockOf(0), partition.BlockOf(2));
+  ASSERT_EQ(partition.BlockSize(0), 2);
+}
+
+TEST(DfaHopcroft, SuccessCase1) {
   auto dfaTable = Dfa::DfaTable{
       {1, {{"a", 3}}},
       {2, {{"a", 1}}},
@@ -13,17 +37,12 @@ TEST(DfaHopcroftOne, SuccessCase1) {
   };
 
   auto dfa = Dfa{dfaTable, 1, {3}};
+  auto res = dfa.Hopcroft();
 
-  auto splitIndexTable = Dfa::SplitIndexTable{};
-  splitIndexTable[1] = splitIndexTable[2] = 0;
-  splitIndexTable[3] = 1;
-
-  auto freeSplitId = Dfa::SplitId{2};
-  auto res = dfa.HopcroftSplit(splitIndexTable, {1, 2}, freeSplitId);
-
-  ASSERT_EQ(res, (Dfa::SplitTalbe{{2, {1}}, {3, {2}}}));
+  ASSERT_EQ(res.GetDfaTable().size(), 3);
 }
-TEST(DfaHopcroftOne, NoNewSplitCase1) {
+
+TEST(DfaHopcroft, NoNewSplitCase1) {
   auto dfaTable = Dfa::DfaTable{
       {1, {{"a", 3}}},
       {2, {{"a", 3}}},
@@ -31,15 +50,15 @@ TEST(DfaHopcroftOne, NoNewSplitCase1) {
   };
 
   auto dfa = Dfa{dfaTable, 1, {3}};
+  auto res = dfa.Hopcroft();
 
-  auto splitIndexTable = Dfa::SplitIndexTable{};
-  splitIndexTable[1] = splitIndexTable[2] = 0;
-  splitIndexTable[3] = 1;
-
-  auto freeSplitId = Dfa::SplitId{2};
-  auto res = dfa.HopcroftSplit(splitIndexTable, {1, 2}, freeSplitId);
-
-  ASSERT_EQ(res, (Dfa::SplitTalbe{{0, {1, 2}}}));
+  auto resDfaTable = Dfa::DfaTable{
+      {0, {{"a", 1}}},
+      {1, {}},
+  };
+  ASSERT_EQ(res.GetDfaTable(), resDfaTable);
+  ASSERT_EQ(res.GetS(), 0);
+  ASSERT_EQ(res.GetF(), (States{1}));
 }
 
 TEST(DfaHopcroft, Case1) {
@@ -58,4 +77,98 @@ TEST(DfaHopcroft, Case1) {
   };
 
   ASSERT_EQ(res.GetDfaTable(), resDfaTable);
-}
\ No newline at end of file
+}
+
+TEST(DfaHopcroft, MissingTransition) {
+  // 1 and 2 both go to a non-final state on "a", 0 has no "a" at all.
+  auto dfaTable = Dfa::DfaTable{
+      {0, {{"b", 3}}},
+      {1, {{"a", 4}, {"b", 3}}},
+      {2, {{"a", 4}, {"b", 3}}},
+      {3, {}},
+      {4, {}},
+  };
+
+  auto dfa = Dfa{dfaTable, 0, {3}};
+  auto res = dfa.Minimize();
+
+  // {0}, {1, 2}, {3}, {4}
+  ASSERT_EQ(res.GetDfaTable().size(), 4);
+}
+
+TEST(DfaHopcroft, Case2) {
+  // (a|b)*(aa|bb)(a|b)*
+  auto dfaTable = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 2}}}, {1, {{"a", 3}, {"b", 2}}},
+      {2, {{"a", 1}, {"b", 4}}}, {3, {{"a", 3}, {"b", 5}}},
+      {4, {{"a", 6}, {"b", 4}}}, {5, {{"a", 6}, {"b", 4}}},
+      {6, {{"a", 3}, {"b", 5}}},
+  };
+
+  auto dfa = Dfa{dfaTable, 0, {3, 4, 5, 6}};
+  auto res = dfa.Minimize().ReorderStates();
+
+  auto resDfaTable = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 2}}},
+      {1, {{"a", 3}, {"b", 2}}},
+      {2, {{"a", 1}, {"b", 3}}},
+      {3, {{"a", 3}, {"b", 3}}},
+  };
+  ASSERT_EQ(res.GetDfaTable(), resDfaTable);
+  ASSERT_EQ(res.GetF(), (States{3}));
+}
+
+TEST(DfaHopcroft, Sink) {
+  // (a|b)*(aa|bb)(a|b)*
+  auto dfaTable = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 2}}}, {1, {{"a", 3}, {"b", 2}}},
+      {2, {{"a", 1}, {"b", 4}}}, {3, {{"a", 3}, {"b", 5}}},
+      {4, {{"a", 6}, {"b", 4}}}, {5, {{"a", 6}, {"b", 4}}},
+      {6, {{"a", 3}, {"b", 5}}},
+  };
+  auto dfa = Dfa{dfaTable, 0, {3, 4, 5, 6}};
+
+  auto logger = DfaLogger{};
+  auto res = dfa.Minimize(logger);
+  ASSERT_EQ(res.GetDfaTable(), dfa.Minimize().GetDfaTable());
+
+  // {0, 1, 2}, {3, 4, 5, 6} split twice into 4 splits.
+  const auto &hopcroft_log = logger.hopcroft_log;
+  EXPECT_EQ(hopcroft_log.source.states.size(), 7);
+  EXPECT_EQ(hopcroft_log.target.states.size(), 4);
+  ASSERT_EQ(hopcroft_log.hopcroftSplitLogs.size(), 2);
+  EXPECT_EQ(hopcroft_log.hopcroftSplitLogs[0].source.splits.size(), 2);
+  EXPECT_EQ(hopcroft_log.hopcroftSplitLogs[1].target.splits.size(), 4);
+}
+
+TEST(DfaMinimize, Parallel) {
+  auto e = std::default_random_engine{0};
+  for (int i = 0; i < 500; ++i) {
+    const auto n = std::uniform_int_distribution<StateId>{1, 30}(e);
+    auto u = std::uniform_int_distribution<StateId>{0, n - 1};
+    auto coin = std::uniform_int_distribution<int>{0, 3};
+
+    auto dfaTable = Dfa::DfaTable{};
+    auto f = States{};
+    for (StateId state = 0; state < n; ++state) {
+      dfaTable[state];
+      for (const auto *terminal : {"a", "b", "c"}) {
+        if (coin(e) != 0) {
+          dfaTable[state][terminal] = u(e);
+        }
+      }
+      if (coin(e) == 0) {
+        f.emplace(state);
+      }
+    }
+
+    const auto dfa = Dfa{dfaTable, u(e), f};
+    const auto expected = dfa.Minimize();
+    for (size_t thread_count : {2, 3, 8}) {
+      const auto res = dfa.Minimize(thread_count);
+      ASSERT_EQ(res.GetDfaTable(), expected.GetDfaTable());
+      ASSERT_EQ(res.GetS(), expected.GetS());
+      ASSERT_EQ(res.GetF(), expected.GetF());
+    }
+  }
+}
@@ -0,0 +1,93 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/dfa-product.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+[[nodiscard]] bool Accepts(const Dfa &dfa, std::string_view input) {
+  auto u = dfa.GetS();
+  for (auto c : input) {
+    const auto &trans_table = dfa.GetDfaTable().at(u);
+    auto it = trans_table.find(Terminal{c});
+    if (it == trans_table.end()) {
+      return false;
+    }
+    u = it->second;
+  }
+  return dfa.GetF().contains(u);
+}
+
+[[nodiscard]] Dfa ToDfa(std::string_view pattern) {
+  return RegexToNfa(pattern).ToDfa().Minimize();
+}
+
+}  // namespace
+
+TEST(DfaProduct, SameAsDefinition) {
+  const auto a = ToDfa("(a|b)*abb");
+  const auto b = ToDfa("a(a|b|c)*");
+  const auto ops = std::vector<std::pair<Dfa, std::function<bool(bool, bool)>>>{
+      {Intersection(a, b), [](bool x, bool y) { return x && y; }},
+      {Union(a, b), [](bool x, bool y) { return x || y; }},
+      {Difference(a, b), [](bool x, bool y) { return x && !y; }},
+      {SymmetricDifference(a, b), [](bool x, bool y) { return x != y; }},
+      {Complement(a, {"a", "b", "c"}), [](bool x, bool) { return !x; }},
+  };
+
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<int>{0, 2};
+  for (size_t i = 0; i < 1000; ++i) {
+    auto input = std::string(i % 8, 'a');
+    for (auto &c : input) {
+      c = "abc"[u(e)];
+    }
+    const auto in_a = Accepts(a, input);
+    const auto in_b = Accepts(b, input);
+    for (size_t j = 0; j < ops.size(); ++j) {
+      ASSERT_EQ(Accepts(ops[j].first, input), ops[j].second(in_a, in_b))
+          << j << " " << input;
+    }
+  }
+}
+
+TEST(DfaProduct, Minimal) {
+  // (a|b)*abb and its own union, intersection are the same 4 states.
+  const auto a = ToDfa("(a|b)*abb");
+  EXPECT_EQ(Intersection(a, a).GetDfaTable().size(), 4);
+  EXPECT_EQ(Union(a, a).GetDfaTable().size(), 4);
+
+  // ab* minus a is ab+.
+  const auto diff = Difference(ToDfa("ab*"), ToDfa("a"));
+  EXPECT_EQ(diff.GetDfaTable().size(), ToDfa("ab+").GetDfaTable().size());
+  EXPECT_FALSE(Accepts(diff, "a"));
+  EXPECT_TRUE(Accepts(diff, "abb"));
+
+  // Complement of a* over {a} is empty.
+  const auto none = Complement(ToDfa("a*"));
+  EXPECT_TRUE(none.GetF().empty());
+}
+
+TEST(DfaProduct, FindWord) {
+  const auto a = ToDfa("[a-c]*");
+  const auto b = ToDfa("(a|b)*");
+  const auto product = DfaProduct{a, b};
+  EXPECT_EQ(product.FindWord(ProductOp::kDifference),
+            (std::vector<Terminal>{"c"}));
+  EXPECT_FALSE(product.IsEmpty(ProductOp::kDifference));
+  EXPECT_TRUE(DfaProduct(b, a).IsEmpty(ProductOp::kDifference));
+  EXPECT_EQ(product.FindWord(ProductOp::kIntersection),
+            std::vector<Terminal>{});
+
+  // Shortest word in abb* but not in ab.
+  EXPECT_EQ(DfaProduct(ToDfa("abb*"), ToDfa("ab")).FindWord(
+                ProductOp::kDifference),
+            (std::vector<Terminal>{"a", "b", "b"}));
+}
@@ -0,0 +1,98 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/dfa-scanner.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+[[nodiscard]] DenseDfa Compile(std::string_view pattern) {
+  return DenseDfa{RegexToNfa(pattern).ToDfa().Minimize()};
+}
+
+/**
+ * Matches of input fed in chunks of random sizes up to max_chunk.
+ */
+[[nodiscard]] std::vector<Match> ScanInChunks(const DenseDfa &dfa,
+                                              std::string_view input,
+                                              size_t max_chunk,
+                                              std::default_random_engine &e) {
+  auto res = std::vector<Match>{};
+  auto on_match = [&res](const Match &match) { res.emplace_back(match); };
+  auto len = std::uniform_int_distribution<size_t>{0, max_chunk};
+
+  auto scanner = DfaScanner{dfa.View()};
+  for (size_t begin = 0; begin < input.size();) {
+    const auto size = std::min(len(e), input.size() - begin);
+    scanner.Feed(input.substr(begin, size), on_match);
+    begin += size;
+    EXPECT_EQ(scanner.GetOffset(), begin);
+  }
+  scanner.Finish(on_match);
+  EXPECT_EQ(scanner.GetOffset(), 0);
+  return res;
+}
+
+}  // namespace
+
+TEST(DfaScanner, Simple) {
+  const auto dfa = Compile("ab|abcd|cd");
+  auto scanner = DfaScanner{dfa.View()};
+  auto res = std::vector<Match>{};
+  auto on_match = [&res](const Match &match) { res.emplace_back(match); };
+
+  scanner.Feed("xxab", on_match);
+  // abcd could still follow.
+  EXPECT_TRUE(res.empty());
+  scanner.Feed("c", on_match);
+  EXPECT_TRUE(res.empty());
+  scanner.Feed("x", on_match);
+  EXPECT_EQ(res, (std::vector<Match>{{2, 4}}));
+  scanner.Feed("abc", on_match);
+  scanner.Feed("dcd", on_match);
+  EXPECT_EQ(res, (std::vector<Match>{{2, 4}, {6, 10}}));
+  scanner.Finish(on_match);
+  EXPECT_EQ(res, (std::vector<Match>{{2, 4}, {6, 10}, {10, 12}}));
+}
+
+TEST(DfaScanner, SameAsFindAll) {
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<int>{0, 2};
+  for (auto pattern : {"a", "ab|abcd|cd", "a*b", "(ab)*c?", "a|aab|b",
+                       "(a|b)*c", "b(a|b){2}", "a?", "(ab|ba)+|c(a|b)*c"}) {
+    const auto dfa = Compile(pattern);
+    for (size_t i = 0; i < 200; ++i) {
+      auto input = std::string(i % 100, 'a');
+      for (auto &c : input) {
+        c = "abc"[u(e)];
+      }
+      const auto expected = dfa.FindAll(input);
+      for (size_t max_chunk : {1, 3, 64}) {
+        ASSERT_EQ(ScanInChunks(dfa, input, max_chunk, e), expected)
+            << pattern << " on " << input;
+      }
+    }
+  }
+}
+
+TEST(DfaScanner, ThreadCount) {
+  // Attempts from every position meet in the same state.
+  const auto dfa = Compile("(a|b)*c");
+  auto scanner = DfaScanner{dfa.View()};
+  auto count = size_t{0};
+  for (size_t i = 0; i < 1000; ++i) {
+    scanner.Feed("ab", [&count](const Match &) { ++count; });
+    ASSERT_LE(scanner.GetThreadCount(), dfa.StateCount());
+  }
+  scanner.Feed("c", [&count](const Match &) { ++count; });
+  // The match could still grow.
+  EXPECT_EQ(count, 0);
+  scanner.Finish([&count](const Match &) { ++count; });
+  EXPECT_EQ(count, 1);
+}
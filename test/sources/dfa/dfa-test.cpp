@@ -44,8 +44,36 @@ TEST(DfaGetStates, Case1) {
 
   auto dfa = Dfa{dfa_table, 0, {}};
 
-  //
-  ASSERT_TRUE((dfa.GetStates() == states));
+  // s is a state even if it is not a key.
+  states.emplace(0);
+  ASSERT_EQ(dfa.GetStates(), toFlatStates(states));
+}
+
+TEST(DfaIndex, Case1) {
+  auto dfa_table = Dfa::DfaTable{
+      {2, {{"b", 4}, {"a", 2}, {"c", 10}}},
+      {4, {{"a", 2}}},
+      {10, {}},
+  };
+  auto dfa = Dfa{dfa_table, 2, {2, 4, 7}};
+  const auto &index = dfa.GetIndex();
+
+  EXPECT_EQ(index.states, (FlatStates{2, 4, 7, 10}));
+  EXPECT_EQ(index.terminals, (std::vector<Terminal>{"a", "b", "c"}));
+  EXPECT_EQ(index.stateIndex.at(10), 3);
+  EXPECT_EQ(index.terminalIndex.at("c"), 2);
+  using OutEdge = Dfa::Index::OutEdge;
+  EXPECT_TRUE(std::ranges::equal(
+      index.GetOutEdges(0), std::vector<OutEdge>{{0, 0}, {1, 1}, {2, 3}}));
+  EXPECT_TRUE(std::ranges::equal(index.GetOutEdges(1),
+                                 std::vector<OutEdge>{{0, 0}}));
+  EXPECT_TRUE(index.GetOutEdges(2).empty());
+  EXPECT_TRUE(index.GetOutEdges(3).empty());
+
+  // Built once and shared by copies.
+  const auto copy = dfa;
+  EXPECT_EQ(&copy.GetIndex(), &index);
+  EXPECT_EQ(&dfa.GetIndex(), &index);
 }
 
 TEST(DfaReorderStates, Case1) {
@@ -59,3 +87,27 @@ TEST(DfaReorderStates, Case1) {
 
   // todo table
 }
+
+TEST(DfaTrim, Case1) {
+  // 3 is a dead end, 5 is unreachable.
+  auto dfa_table = Dfa::DfaTable{
+      {1, {{"a", 2}, {"b", 3}}},
+      {2, {{"a", 1}}},
+      {3, {{"a", 3}}},
+      {5, {{"a", 1}}},
+  };
+  auto res = Dfa{dfa_table, 1, {2, 5}, {{5, {1}}}}.Trim();
+
+  const auto resDfaTable = Dfa::DfaTable{
+      {1, {{"a", 2}}},
+      {2, {{"a", 1}}},
+  };
+  ASSERT_EQ(res.GetDfaTable(), resDfaTable);
+  ASSERT_EQ(res.GetS(), 1);
+  ASSERT_EQ(res.GetF(), (States{2}));
+  ASSERT_TRUE(res.GetAcceptTable().empty());
+
+  // Nothing accepted, the start state stays.
+  res = Dfa{dfa_table, 3, {2}}.Trim();
+  ASSERT_EQ(res.GetDfaTable(), (Dfa::DfaTable{{3, {}}}));
+}
@@ -0,0 +1,104 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/incremental-dfa.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+[[nodiscard]] PatternIds PatternsOf(const Dfa &dfa, std::string_view input) {
+  auto u = dfa.GetS();
+  for (auto c : input) {
+    const auto &trans_table = dfa.GetDfaTable().at(u);
+    auto it = trans_table.find(Terminal{c});
+    if (it == trans_table.end()) {
+      return {};
+    }
+    u = it->second;
+  }
+  const auto patterns = dfa.GetPatterns(u);
+  return {patterns.begin(), patterns.end()};
+}
+
+/**
+ * Check dfa against rebuilding patterns[i] (with id ids[i]) from scratch.
+ */
+void ExpectSameAsRebuild(const Dfa &dfa,
+                         const std::vector<std::string_view> &patterns,
+                         const PatternIds &ids) {
+  auto nfas = std::vector<Nfa>{};
+  auto dfas = std::vector<Dfa>{};
+  for (auto pattern : patterns) {
+    nfas.emplace_back(RegexToNfa(pattern));
+    dfas.emplace_back(nfas.back().ToDfa());
+  }
+  const auto rebuilt = Nfa::Union(nfas).ToDfa().Minimize();
+  EXPECT_EQ(dfa.GetDfaTable().size(), rebuilt.GetDfaTable().size());
+
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<int>{0, 2};
+  for (size_t i = 0; i < 500; ++i) {
+    auto input = std::string(i % 7, 'a');
+    for (auto &c : input) {
+      c = "abc"[u(e)];
+    }
+    auto expected = PatternIds{};
+    for (size_t j = 0; j < dfas.size(); ++j) {
+      if (!PatternsOf(dfas[j], input).empty()) {
+        expected.emplace_back(ids[j]);
+      }
+    }
+    ASSERT_EQ(PatternsOf(dfa, input), expected) << input;
+  }
+}
+
+}  // namespace
+
+TEST(IncrementalDfa, Empty) {
+  const auto dfa = IncrementalDfa{};
+  EXPECT_EQ(dfa.GetDfa().GetDfaTable().size(), 1);
+  EXPECT_TRUE(dfa.GetDfa().GetF().empty());
+  EXPECT_TRUE(dfa.GetPatterns().empty());
+}
+
+TEST(IncrementalDfa, AddRemove) {
+  auto dfa = IncrementalDfa{};
+  EXPECT_EQ(dfa.Add("a+"), 0);
+  EXPECT_EQ(dfa.Add("(a|b)*abb"), 1);
+  EXPECT_EQ(dfa.Add("[a-c]b"), 2);
+  EXPECT_EQ(dfa.Add("b*"), 3);
+  ExpectSameAsRebuild(dfa.GetDfa(), {"a+", "(a|b)*abb", "[a-c]b", "b*"},
+                      {0, 1, 2, 3});
+
+  EXPECT_TRUE(dfa.Remove(1));
+  EXPECT_FALSE(dfa.Remove(1));
+  EXPECT_EQ(dfa.GetPatterns(), (PatternIds{0, 2, 3}));
+  ExpectSameAsRebuild(dfa.GetDfa(), {"a+", "[a-c]b", "b*"}, {0, 2, 3});
+
+  EXPECT_EQ(dfa.Add("c(a|b)*"), 4);
+  ExpectSameAsRebuild(dfa.GetDfa(), {"a+", "[a-c]b", "b*", "c(a|b)*"},
+                      {0, 2, 3, 4});
+
+  for (PatternId pattern : {0, 3, 4, 2}) {
+    EXPECT_TRUE(dfa.Remove(pattern));
+  }
+  EXPECT_EQ(dfa.GetDfa().GetDfaTable().size(), 1);
+  EXPECT_TRUE(dfa.GetDfa().GetF().empty());
+}
+
+TEST(IncrementalDfa, SharedPrefix) {
+  // Removing "abc" leaves states only "abd" needs.
+  auto dfa = IncrementalDfa{};
+  const auto abc = dfa.Add("abc");
+  dfa.Add("abd");
+  EXPECT_EQ(dfa.GetDfa().GetDfaTable().size(), 5);
+  dfa.Remove(abc);
+  EXPECT_EQ(dfa.GetDfa().GetDfaTable().size(), 4);
+  ExpectSameAsRebuild(dfa.GetDfa(), {"abd"}, {1});
+}
@@ -0,0 +1,115 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+[[nodiscard]] std::vector<Nfa> ToNfas(
+    std::initializer_list<std::string_view> patterns) {
+  auto res = std::vector<Nfa>{};
+  for (auto pattern : patterns) {
+    res.emplace_back(RegexToNfa(pattern));
+  }
+  return res;
+}
+
+/**
+ * Patterns accepted by dfa on input, walking the Dfa itself.
+ */
+[[nodiscard]] PatternIds PatternsOf(const Dfa &dfa, std::string_view input) {
+  auto u = dfa.GetS();
+  for (auto c : input) {
+    const auto &trans_table = dfa.GetDfaTable().at(u);
+    auto it = trans_table.find(Terminal{c});
+    if (it == trans_table.end()) {
+      return {};
+    }
+    u = it->second;
+  }
+  const auto patterns = dfa.GetPatterns(u);
+  return {patterns.begin(), patterns.end()};
+}
+
+}  // namespace
+
+TEST(MultiPattern, Union) {
+  const auto nfas = ToNfas({"a+", "ab", "[a-c]b", "b*"});
+  const auto nfa = Nfa::Union(nfas);
+  const auto dfa = nfa.ToDfa();
+  const auto min_dfa = dfa.Minimize();
+  const auto dense_dfa = DenseDfa{min_dfa};
+
+  auto dfas = std::vector<Dfa>{};
+  for (const auto &single : nfas) {
+    dfas.emplace_back(single.ToDfa());
+  }
+
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<int>{0, 2};
+  for (size_t i = 0; i < 500; ++i) {
+    auto input = std::string(i % 6, 'a');
+    for (auto &c : input) {
+      c = "abc"[u(e)];
+    }
+
+    auto expected = PatternIds{};
+    for (PatternId pattern = 0; pattern < dfas.size(); ++pattern) {
+      if (!PatternsOf(dfas[pattern], input).empty()) {
+        expected.emplace_back(pattern);
+      }
+    }
+    ASSERT_EQ(PatternsOf(dfa, input), expected) << input;
+    ASSERT_EQ(PatternsOf(min_dfa, input), expected) << input;
+
+    auto v = dense_dfa.GetS();
+    for (auto c : input) {
+      if (v != DenseDfa::kDeadState) {
+        v = dense_dfa.Next(v, static_cast<std::byte>(c));
+      }
+    }
+    const auto patterns = v == DenseDfa::kDeadState
+                              ? std::span<const PatternId>{}
+                              : dense_dfa.GetPatterns(v);
+    ASSERT_EQ((PatternIds{patterns.begin(), patterns.end()}), expected)
+        << input;
+  }
+}
+
+TEST(MultiPattern, MinimizeKeepsPatternsApart) {
+  // Without patterns both final states merge.
+  const auto nfas = ToNfas({"a", "b"});
+  EXPECT_EQ(RegexToNfa("a|b").ToDfa().Minimize().GetDfaTable().size(), 2);
+
+  const auto dfa = Nfa::Union(nfas).ToDfa();
+  for (const auto &min_dfa : {dfa.Minimize(), dfa.Minimize(2)}) {
+    EXPECT_EQ(min_dfa.GetDfaTable().size(), 3);
+    EXPECT_EQ(PatternsOf(min_dfa, "a"), PatternIds{0});
+    EXPECT_EQ(PatternsOf(min_dfa, "b"), PatternIds{1});
+  }
+}
+
+TEST(MultiPattern, ParallelToDfa) {
+  const auto nfa = Nfa::Union(ToNfas({"(a|b)*a(a|b){3}", "(a|b)*bb", "a*"}));
+  const auto expected = nfa.ToDfa();
+  for (size_t thread_count : {2, 4}) {
+    const auto res = nfa.ToDfa(thread_count);
+    ASSERT_EQ(res.GetDfaTable(), expected.GetDfaTable());
+    ASSERT_EQ(res.GetF(), expected.GetF());
+    ASSERT_EQ(res.GetAcceptTable(), expected.GetAcceptTable());
+  }
+}
+
+TEST(MultiPattern, DefaultPattern) {
+  const auto dfa = RegexToNfa("ab*").ToDfa().Minimize();
+  EXPECT_TRUE(dfa.GetAcceptTable().empty());
+  EXPECT_EQ(PatternsOf(dfa, "ab"), PatternIds{0});
+  EXPECT_EQ(PatternsOf(dfa, "b"), PatternIds{});
+}
@@ -0,0 +1,96 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/multi-stream-dfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+using Kernel = MultiStreamDfa::Kernel;
+
+[[nodiscard]] DenseDfa Compile(std::string_view pattern) {
+  return DenseDfa{RegexToNfa(pattern).ToDfa().Minimize()};
+}
+
+/**
+ * Records over a small alphabet, lengths 0 to 200, so lanes finish at
+ * different times.
+ */
+[[nodiscard]] std::vector<std::string> RandomRecords(size_t count) {
+  auto e = std::default_random_engine{0};
+  auto len = std::uniform_int_distribution<size_t>{0, 200};
+  auto u = std::uniform_int_distribution<int>{0, 3};
+  auto res = std::vector<std::string>{};
+  for (size_t i = 0; i < count; ++i) {
+    auto record = std::string(len(e) % (i % 3 == 0 ? 4 : 201), 'a');
+    for (auto &c : record) {
+      c = "ab.@"[u(e)];
+    }
+    res.emplace_back(std::move(record));
+  }
+  return res;
+}
+
+void ExpectSameAsDenseDfa(const DenseDfa &dense, Kernel kernel) {
+  const auto records = RandomRecords(1000);
+  const auto inputs =
+      std::vector<std::string_view>{records.begin(), records.end()};
+  auto expected = std::vector<uint8_t>{};
+  for (auto input : inputs) {
+    expected.emplace_back(dense.Accepts(input));
+  }
+
+  const auto dfa = MultiStreamDfa{dense.View(), kernel};
+  ASSERT_EQ(dfa.Accepts(inputs), expected);
+
+  auto results = std::vector<uint8_t>(inputs.size());
+  dfa.AcceptsInterleaved<1>(std::span{inputs}, std::span{results});
+  ASSERT_EQ(results, expected);
+  dfa.AcceptsInterleaved<4>(std::span{inputs}, std::span{results});
+  ASSERT_EQ(results, expected);
+  dfa.AcceptsInterleaved<16>(std::span{inputs}, std::span{results});
+  ASSERT_EQ(results, expected);
+}
+
+}  // namespace
+
+TEST(MultiStreamDfa, Kernels) {
+  // Small enough for the shuffle kernels.
+  const auto small = Compile("(a|b)*a(a|b)(a|b)");
+  ASSERT_LT(small.StateCount(), MultiStreamDfa::kMaxShuffleStates);
+  for (auto kernel : {Kernel::kAuto, Kernel::kInterleaved, Kernel::kSsse3,
+                      Kernel::kAvx2}) {
+    const auto dfa = MultiStreamDfa{small.View(), kernel};
+    if (kernel != Kernel::kAuto) {
+      ASSERT_EQ(dfa.GetKernel(), MultiStreamDfa::IsSupported(kernel)
+                                     ? kernel
+                                     : Kernel::kInterleaved);
+    }
+    ExpectSameAsDenseDfa(small, kernel);
+  }
+
+  // Dies on '.' and '@', so lanes stop early.
+  ExpectSameAsDenseDfa(Compile("[ab]*"), Kernel::kAuto);
+}
+
+TEST(MultiStreamDfa, LargeDfa) {
+  const auto large = Compile("(a|b)*a(a|b){5}");
+  ASSERT_GT(large.StateCount(), MultiStreamDfa::kMaxShuffleStates);
+  ASSERT_EQ((MultiStreamDfa{large.View(), Kernel::kSsse3}.GetKernel()),
+            Kernel::kInterleaved);
+  ExpectSameAsDenseDfa(large, Kernel::kAuto);
+}
+
+TEST(MultiStreamDfa, Empty) {
+  const auto dfa = MultiStreamDfa{Compile("a*").View()};
+  ASSERT_EQ(dfa.Accepts(std::vector<std::string_view>{}),
+            std::vector<uint8_t>{});
+  ASSERT_EQ(dfa.Accepts(std::vector<std::string_view>{"", "aa", "", "b"}),
+            (std::vector<uint8_t>{1, 1, 1, 0}));
+}
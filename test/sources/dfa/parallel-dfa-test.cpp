@@ -0,0 +1,115 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/parallel-dfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+using DenseStateId = ParallelDfa::DenseStateId;
+
+[[nodiscard]] DenseDfa Compile(std::string_view pattern) {
+  return DenseDfa{RegexToNfa(pattern).ToDfa().Minimize()};
+}
+
+[[nodiscard]] std::string RandomText(size_t size, std::string_view alphabet) {
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<size_t>{0, alphabet.size() - 1};
+  auto res = std::string(size, ' ');
+  for (auto &c : res) {
+    c = alphabet[u(e)];
+  }
+  return res;
+}
+
+[[nodiscard]] DenseStateId SequentialRun(const DenseDfa &dfa,
+                                         std::string_view input) {
+  auto u = dfa.GetS();
+  for (auto c : input) {
+    if (u == ParallelDfa::kDeadState) {
+      break;
+    }
+    u = dfa.Next(u, static_cast<std::byte>(c));
+  }
+  return u;
+}
+
+[[nodiscard]] std::vector<size_t> SequentialMatchEnds(const DenseDfa &dfa,
+                                                      std::string_view input) {
+  auto res = std::vector<size_t>{};
+  auto u = dfa.GetS();
+  for (size_t i = 0; i <= input.size() && u != ParallelDfa::kDeadState; ++i) {
+    if (dfa.IsAccepting(u)) {
+      res.emplace_back(i);
+    }
+    if (i < input.size()) {
+      u = dfa.Next(u, static_cast<std::byte>(input[i]));
+    }
+  }
+  return res;
+}
+
+void ExpectSameAsSequential(const DenseDfa &dfa, std::string_view input,
+                            ParallelDfa::Options options) {
+  const auto expected_end = SequentialRun(dfa, input);
+  const auto expected_ends = SequentialMatchEnds(dfa, input);
+  for (size_t thread_count : {1, 3}) {
+    auto parallel = ParallelDfa{dfa.View(), thread_count, options};
+    ASSERT_EQ(parallel.Run(DenseDfaView::AsBytes(input)), expected_end);
+    ASSERT_EQ(parallel.Accepts(input), dfa.Accepts(input));
+    ASSERT_EQ(parallel.MatchEnds(input), expected_ends);
+  }
+}
+
+}  // namespace
+
+TEST(ParallelDfa, Enumerated) {
+  const auto dfa = Compile(".*ab[ab]c");
+  const auto text = RandomText(20000, "abc");
+  for (size_t chunk_size : {1, 7, 4096, 1 << 20}) {
+    ExpectSameAsSequential(dfa, text, {.chunkSize = chunk_size});
+  }
+}
+
+TEST(ParallelDfa, Speculated) {
+  const auto dfa = Compile(".*ab[ab]c");
+  const auto text = RandomText(20000, "abc");
+  for (size_t lookback : {0, 1, 16}) {
+    for (size_t chunk_size : {1, 7, 5000}) {
+      ExpectSameAsSequential(dfa, text,
+                             {.chunkSize = chunk_size,
+                              .maxEnumeratedStates = 0,
+                              .lookback = lookback});
+    }
+  }
+}
+
+TEST(ParallelDfa, LargeDfa) {
+  // 2^9 states, one byte of lookback is never enough.
+  const auto dfa = Compile("(a|b)*a(a|b){8}");
+  const auto text = RandomText(50000, "ab");
+  ExpectSameAsSequential(dfa, text, {.chunkSize = 3000});
+  ExpectSameAsSequential(dfa, text, {.chunkSize = 9000, .lookback = 4});
+}
+
+TEST(ParallelDfa, Dead) {
+  const auto dfa = Compile("a*b");
+  ExpectSameAsSequential(dfa, std::string(10000, 'a') + "b",
+                         {.chunkSize = 1000});
+  ExpectSameAsSequential(dfa, std::string(10000, 'a') + "c" + "aaab",
+                         {.chunkSize = 1000});
+  ExpectSameAsSequential(dfa, std::string(10000, 'a') + "c" + "aaab",
+                         {.chunkSize = 1000, .maxEnumeratedStates = 0});
+}
+
+TEST(ParallelDfa, Empty) {
+  const auto dfa = Compile("a*");
+  ExpectSameAsSequential(dfa, "", {});
+  ExpectSameAsSequential(dfa, "", {.maxEnumeratedStates = 0});
+}
@@ -0,0 +1,68 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+#include "regex-fa/static-dfa.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+template <FixedString kPattern>
+void ExpectSameAsDenseDfa(std::string_view alphabet) {
+  using Static = StaticDfa<kPattern>;
+  const auto dense =
+      DenseDfa{RegexToNfa(Static::GetPattern()).ToDfa().Minimize()};
+
+  auto e = std::default_random_engine{0};
+  auto u = std::uniform_int_distribution<size_t>{0, alphabet.size() - 1};
+  for (size_t i = 0; i < 500; ++i) {
+    auto input = std::string(i % 12, ' ');
+    for (auto &c : input) {
+      c = alphabet[u(e)];
+    }
+    ASSERT_EQ(Static::Accepts(input), dense.Accepts(input)) << input;
+    ASSERT_EQ(Static::LongestMatch(input), dense.LongestMatch(input)) << input;
+    ASSERT_EQ(Static::FindAll(input), dense.FindAll(input)) << input;
+  }
+}
+
+}  // namespace
+
+TEST(StaticDfa, ConstantEvaluated) {
+  using Abb = StaticDfa<"(a|b)*abb">;
+  static_assert(Abb::StateCount() == 5);  // 4 states and the dead state
+  static_assert(Abb::ClassCount() == 3);
+  static_assert(Abb::Accepts("babb"));
+  static_assert(!Abb::Accepts("abba"));
+  static_assert(!Abb::Accepts("abc"));
+  static_assert(Abb::LongestMatch("abbabbc") == 6);
+  static_assert(!Abb::LongestMatch("c").has_value());
+
+  using Mail = StaticDfa<"[a-z]+@[a-z]+\\.com">;
+  static_assert(Mail::LongestMatch("foo@bar.comx") == 11);
+  static_assert(Mail::Next(Mail::GetS(), '@') == Mail::kDeadState);
+  static_assert(std::is_same_v<Mail::StaticStateId, uint8_t>);
+}
+
+TEST(StaticDfa, Empty) {
+  using Empty = StaticDfa<"">;
+  static_assert(Empty::Accepts(""));
+  static_assert(!Empty::Accepts("a"));
+  static_assert(Empty::LongestMatch("a") == 0);
+  EXPECT_TRUE(Empty::FindAll("abc").empty());
+}
+
+TEST(StaticDfa, SameAsDenseDfa) {
+  ExpectSameAsDenseDfa<"a">("ab");
+  ExpectSameAsDenseDfa<"(a|b)*a(a|b){3}">("abc");
+  ExpectSameAsDenseDfa<"(ab|a)*(ba|b)*">("ab");
+  ExpectSameAsDenseDfa<"x?y?z?">("xyz");
+  ExpectSameAsDenseDfa<"[^a]+b?">("abc");
+  ExpectSameAsDenseDfa<".*error:[0-9]+">("error:019 \n");
+}
@@ -9,4 +9,45 @@ using namespace regex_fa;
 TEST(FaGraphGetReachable, case1) {
   FaUnweightedGraph graph = {{1, {3}}, {2, {3}}, {3, {}}};
   ASSERT_EQ((GetReachable(graph, {1})), (States{1, 3}));
-}
\ No newline at end of file
+}
+TEST(FaGraphGetReachable, Cycle) {
+  FaUnweightedGraph graph = {{1, {2, 3}}, {2, {1, 3}}, {3, {3}}, {4, {1}}};
+  ASSERT_EQ((GetReachable(graph, {1, 2})), (States{1, 2, 3}));
+}
+
+TEST(StateBitset, Insert) {
+  auto bits = StateBitset{130};
+  ASSERT_TRUE(bits.Insert(0));
+  ASSERT_TRUE(bits.Insert(129));
+  ASSERT_FALSE(bits.Insert(129));
+  ASSERT_TRUE(bits.Contains(129));
+  ASSERT_FALSE(bits.Contains(64));
+  ASSERT_EQ(bits.Count(), 2);
+}
+
+TEST(CsrFaGraph, Reachable) {
+  // 0 -> 1 -> 2 -> 1, 3 -> 2, 4 alone.
+  const auto edges =
+      std::vector<CsrFaGraph::Edge>{{0, 1}, {1, 2}, {2, 1}, {3, 2}, {1, 2}};
+  const auto graph = CsrFaGraph{5, edges};
+  ASSERT_EQ(graph.StateCount(), 5);
+  ASSERT_EQ(graph.EdgeCount(), 5);
+  ASSERT_EQ((std::vector<uint32_t>{graph.GetTargets(1).begin(),
+                                   graph.GetTargets(1).end()}),
+            (std::vector<uint32_t>{2, 2}));
+  ASSERT_TRUE(graph.GetTargets(4).empty());
+
+  const auto start = std::array<uint32_t, 1>{0};
+  const auto forward = graph.GetReachable(start);
+  ASSERT_EQ(forward.Count(), 3);
+  ASSERT_FALSE(forward.Contains(3));
+
+  const auto finals = std::array<uint32_t, 1>{2};
+  const auto backward = graph.Reverse().GetReachable(finals);
+  ASSERT_EQ(backward.Count(), 4);
+  ASSERT_FALSE(backward.Contains(4));
+
+  const auto useful = graph.GetUseful(start, finals);
+  ASSERT_EQ(useful.Count(), 3);
+  ASSERT_FALSE(useful.Contains(3));
+}
@@ -0,0 +1,59 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include <random>
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/lazy-dfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+[[nodiscard]] std::string RandomAbString(std::default_random_engine &e) {
+  auto len = std::uniform_int_distribution<size_t>{0, 24}(e);
+  auto u = std::uniform_int_distribution<int>{0, 2};
+  auto res = std::string{};
+  for (size_t i = 0; i < len; ++i) {
+    res.push_back("abc"[u(e)]);
+  }
+  return res;
+}
+
+TEST(LazyDfa, SameAsDfa) {
+  const auto nfa = RegexToNfa("(a|b)*a(a|b){4}c?");
+  const auto dense = DenseDfa{nfa.ToDfa()};
+
+  auto lazy = LazyDfa{nfa};
+  auto e = std::default_random_engine{0};
+  for (int i = 0; i < 1000; ++i) {
+    const auto input = RandomAbString(e);
+    ASSERT_EQ(lazy.Accepts(input), dense.Accepts(input)) << input;
+    ASSERT_EQ(lazy.LongestMatch(input), dense.LongestMatch(input)) << input;
+  }
+  ASSERT_LE(lazy.GetCacheSize(), dense.StateCount());
+  ASSERT_EQ(lazy.GetFlushCount(), 0);
+}
+
+TEST(LazyDfa, BoundedCache) {
+  const auto nfa = RegexToNfa("(a|b)*a(a|b){8}");
+  const auto dense = DenseDfa{nfa.ToDfa()};
+
+  // Enough bytes per flush, the cache is flushed and reused.
+  auto flushing = LazyDfa{nfa, {.maxStates = 64, .minBytesPerState = 0}};
+  // Too few bytes per flush, falls back to Nfa simulation.
+  auto falling_back =
+      LazyDfa{nfa, {.maxStates = 4, .minBytesPerState = 1000}};
+
+  auto e = std::default_random_engine{1};
+  for (int i = 0; i < 200; ++i) {
+    const auto input = RandomAbString(e);
+    ASSERT_EQ(flushing.Accepts(input), dense.Accepts(input)) << input;
+    ASSERT_EQ(falling_back.Accepts(input), dense.Accepts(input)) << input;
+    ASSERT_LE(flushing.GetCacheSize(), 64);
+    ASSERT_LE(falling_back.GetCacheSize(), 4);
+  }
+  ASSERT_GT(flushing.GetFlushCount(), 0);
+  ASSERT_EQ(flushing.GetFallbackCount(), 0);
+  ASSERT_GT(falling_back.GetFallbackCount(), 0);
+}
@@ -0,0 +1,68 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+namespace {
+
+/**
+ * Forwards to new and delete, counting what is outstanding.
+ */
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocations{0};
+  size_t outstanding{0};
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    outstanding += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    outstanding -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  [[nodiscard]] bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+}  // namespace
+
+TEST(MemoryResource, ToDfaAndMinimize) {
+  for (auto pattern : {"a", "(a|b)*abb", "(a|b)*a(a|b){6}", "[a-z]+@[a-z]+"}) {
+    const auto nfa = RegexToNfa(pattern);
+    const auto expected = nfa.ToDfa();
+    const auto expected_min = expected.Minimize();
+
+    auto resource = CountingResource{};
+    const auto dfa = nfa.ToDfa(resource);
+    EXPECT_GT(resource.allocations, 0);
+    EXPECT_EQ(resource.outstanding, 0);
+    ASSERT_EQ(dfa.GetDfaTable(), expected.GetDfaTable()) << pattern;
+    ASSERT_EQ(dfa.GetF(), expected.GetF()) << pattern;
+
+    resource.allocations = 0;
+    const auto min_dfa = dfa.Minimize(resource);
+    EXPECT_GT(resource.allocations, 0);
+    EXPECT_EQ(resource.outstanding, 0);
+    ASSERT_EQ(min_dfa.GetDfaTable(), expected_min.GetDfaTable()) << pattern;
+    ASSERT_EQ(min_dfa.GetF(), expected_min.GetF()) << pattern;
+  }
+}
+
+TEST(MemoryResource, Monotonic) {
+  const auto nfa = RegexToNfa("(a|b)*a(a|b){6}");
+  auto arena = std::pmr::monotonic_buffer_resource{};
+  const auto dfa = nfa.ToDfa(arena).Minimize(arena);
+  arena.release();
+  EXPECT_EQ(dfa.GetDfaTable(), nfa.ToDfa().Minimize().GetDfaTable());
+}
@@ -1,6 +1,8 @@
 // clang-format off
 #include "test.h"
 // clang-format on
+#include <thread>
+
 #include "regex-fa/nfa.hpp"
 
 using namespace regex_fa;
@@ -18,3 +20,146 @@ TEST(NfaToDfa, SuccessCase1) {
 
   // ASSERT_EQ(res,dfa);
 }
+
+TEST(EpsilonClosure, Cycle) {
+  // 0 -> 1 -> 2 -> 1, 2 -> 3, 4 alone.
+  const auto edge_first = std::vector<uint32_t>{0, 1, 2, 4, 4, 4};
+  const auto edges = std::vector<uint32_t>{1, 2, 1, 3};
+  const auto closure = EpsilonClosure{edge_first, edges};
+
+  auto Get = [&closure](uint32_t u) {
+    auto res = closure.Get(u);
+    return std::vector<uint32_t>{res.begin(), res.end()};
+  };
+  ASSERT_EQ(Get(0), (std::vector<uint32_t>{0, 1, 2, 3}));
+  ASSERT_EQ(Get(1), (std::vector<uint32_t>{1, 2, 3}));
+  ASSERT_EQ(Get(2), (std::vector<uint32_t>{1, 2, 3}));
+  ASSERT_EQ(Get(3), (std::vector<uint32_t>{3}));
+  ASSERT_EQ(Get(4), (std::vector<uint32_t>{4}));
+}
+
+TEST(NfaToDfa, Epsilon) {
+  // Thompson NFA of (a|b)*c.
+  const auto nfaTable = Nfa::NfaTable{
+      {0, {{kEpsilon, {1, 6}}}},
+      {1, {{kEpsilon, {2, 3}}}},
+      {2, {{"a", {4}}}},
+      {3, {{"b", {5}}}},
+      {4, {{kEpsilon, {0}}}},
+      {5, {{kEpsilon, {0}}}},
+      {6, {{"c", {7}}}},
+      {7, {}},
+  };
+
+  const auto nfa = Nfa{nfaTable, 0, {7}};
+  const auto res = nfa.ToDfa().Minimize().ReorderStates();
+
+  const auto resDfaTable = Dfa::DfaTable{
+      {0, {{"a", 0}, {"b", 0}, {"c", 1}}},
+      {1, {}},
+  };
+  ASSERT_EQ(res.GetDfaTable(), resDfaTable);
+  ASSERT_EQ(res.GetF(), (States{1}));
+}
+
+TEST(NfaToDfa, EpsilonFlatNfa) {
+  auto flat_nfa = FlatNfa{};
+  flat_nfa.states = {0, 1, 2};
+  flat_nfa.flatEdges = {{0, 1, kEpsilon}, {1, 2, "a"}};
+  flat_nfa.s = 0;
+  flat_nfa.f = {0, 2};
+
+  const auto nfa = Nfa{flat_nfa};
+  ASSERT_EQ(nfa.GetF(), (States{0, 2}));
+
+  const auto res = nfa.ToDfa().ReorderStates();
+  const auto resDfaTable = Dfa::DfaTable{
+      {0, {{"a", 1}}},
+      {1, {}},
+  };
+  ASSERT_EQ(res.GetDfaTable(), resDfaTable);
+  ASSERT_EQ(res.GetF(), (States{0, 1}));
+}
+
+TEST(SubsetTable, Insert) {
+  auto subsets = SubsetTable{};
+  for (uint32_t i = 0; i < 100; ++i) {
+    const auto subset = std::vector<uint32_t>{i, i + 1};
+    ASSERT_EQ(subsets.Insert(subset), std::make_pair(i, true));
+  }
+  ASSERT_EQ(subsets.Insert(std::vector<uint32_t>{5, 6}),
+            std::make_pair(uint32_t{5}, false));
+  ASSERT_EQ(subsets.Find(std::vector<uint32_t>{7, 8}), 7);
+  ASSERT_EQ(subsets.Find(std::vector<uint32_t>{7}), std::nullopt);
+  ASSERT_EQ(subsets.Size(), 100);
+}
+
+TEST(NfaToDfa, BfsOrder) {
+  const auto nfaTable = Nfa::NfaTable{
+      {0, {{"a", {0, 1}}, {"b", {0}}}},
+      {1, {{"b", {2}}}},
+      {2, {}},
+  };
+
+  const auto res = Nfa{nfaTable, 0, {2}}.ToDfa();
+
+  // {0}, {0, 1}, {0, 2} in discovery order.
+  const auto resDfaTable = Dfa::DfaTable{
+      {0, {{"a", 1}, {"b", 0}}},
+      {1, {{"a", 1}, {"b", 2}}},
+      {2, {{"a", 1}, {"b", 0}}},
+  };
+  ASSERT_EQ(res.GetDfaTable(), resDfaTable);
+  ASSERT_EQ(res.GetS(), 0);
+  ASSERT_EQ(res.GetF(), (States{2}));
+}
+
+TEST(NfaToDfa, Sink) {
+  const auto nfaTable = Nfa::NfaTable{
+      {0, {{"a", {0, 1}}, {"b", {0}}}},
+      {1, {{"b", {2}}}},
+      {2, {}},
+  };
+  const auto nfa = Nfa{nfaTable, 0, {2}};
+
+  // One logger per thread, nothing shared.
+  auto loggers = std::vector<NfaLogger>(4);
+  auto results = std::vector<std::optional<Dfa>>(loggers.size());
+  auto threads = std::vector<std::thread>{};
+  for (size_t i = 0; i < loggers.size(); ++i) {
+    threads.emplace_back([&, i] { results[i] = nfa.ToDfa(loggers[i]); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < loggers.size(); ++i) {
+    ASSERT_EQ(results[i]->GetDfaTable(), nfa.ToDfa().GetDfaTable());
+    const auto &sc_log = loggers[i].sc_log;
+    ASSERT_EQ(sc_log.steps.size(), 3);
+    EXPECT_EQ(sc_log.steps[0].curSubset, (FlatStates{0}));
+    EXPECT_EQ(sc_log.steps[0].newSubsets, (std::vector<FlatStates>{{0, 1}}));
+    EXPECT_EQ(sc_log.steps[0].scEdges.size(), 2);
+    EXPECT_EQ(sc_log.steps[1].waitList, (std::vector<FlatStates>{{0, 2}}));
+    EXPECT_EQ(sc_log.target.states.size(), 3);
+  }
+}
+
+TEST(NfaTrim, Case1) {
+  // 3 is a dead end reached by epsilon, 4 is unreachable.
+  const auto nfaTable = Nfa::NfaTable{
+      {0, {{"a", {0, 1, 3}}, {kEpsilon, {3}}}},
+      {1, {}},
+      {3, {{"b", {3}}}},
+      {4, {{"a", {1}}}},
+  };
+  const auto res = Nfa{nfaTable, 0, {1}}.Trim();
+
+  const auto resNfaTable = Nfa::NfaTable{
+      {0, {{"a", {0, 1}}}},
+      {1, {}},
+  };
+  ASSERT_EQ(res.GetNfaTable(), resNfaTable);
+  ASSERT_EQ(res.ToDfa().GetDfaTable(),
+            Nfa(nfaTable, 0, {1}).ToDfa().Trim().ReorderStates().GetDfaTable());
+}
@@ -0,0 +1,45 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+#include "regex-fa/thread-pool.hpp"
+
+using namespace regex_fa;
+
+TEST(ThreadPool, ParallelFor) {
+  auto pool = ThreadPool{4};
+  ASSERT_EQ(pool.Size(), 4);
+
+  for (size_t count : {0, 1, 7, 1000}) {
+    auto hits = std::vector<std::atomic<int>>(count);
+    auto threads = std::vector<std::atomic<int>>(pool.Size());
+    pool.ParallelFor(count, 3, [&](size_t i, size_t thread) {
+      ++hits[i];
+      ++threads[thread];
+    });
+    for (const auto &hit : hits) {
+      ASSERT_EQ(hit, 1);
+    }
+    size_t total = 0;
+    for (const auto &n : threads) {
+      total += n;
+    }
+    ASSERT_EQ(total, count);
+  }
+}
+
+TEST(NfaToDfa, Parallel) {
+  for (auto pattern : {"a", "(a|b)*abb", "(a|b)*a(a|b){8}", "[a-z]+@[a-z]+",
+                       "(ab|a)*(ba|b)*", "x?y?z?"}) {
+    const auto nfa = RegexToNfa(pattern);
+    const auto expected = nfa.ToDfa();
+    for (size_t thread_count : {2, 4, 8}) {
+      const auto res = nfa.ToDfa(thread_count);
+      ASSERT_EQ(res.GetDfaTable(), expected.GetDfaTable()) << pattern;
+      ASSERT_EQ(res.GetS(), expected.GetS());
+      ASSERT_EQ(res.GetF(), expected.GetF());
+    }
+  }
+}
@@ -0,0 +1,100 @@
+// clang-format off
+#include "test.h"
+// clang-format on
+
+#include "regex-fa/dense-dfa.hpp"
+#include "regex-fa/regex.hpp"
+
+using namespace regex_fa;
+
+[[nodiscard]] DenseDfa Compile(std::string_view pattern) {
+  return DenseDfa{RegexToNfa(pattern).ToDfa().Minimize()};
+}
+
+TEST(RegexParser, Ast) {
+  auto ast = RegexParser{"ab|c*"}.Parse();
+  ASSERT_EQ(ast.nodes.size(), 6);
+  ASSERT_EQ(ast.nodes[ast.root].kind, RegexNode::Kind::kAlternate);
+}
+
+TEST(RegexToNfa, Glushkov) {
+  // One state per byte position, plus the start state.
+  auto nfa = RegexToNfa("a(b|c)*");
+  ASSERT_EQ(nfa.GetNfaTable().size(), 4);
+  ASSERT_EQ(nfa.GetS(), 0);
+  ASSERT_EQ(nfa.GetF(), (States{1, 2, 3}));
+}
+
+TEST(RegexToNfa, Operators) {
+  auto dfa = Compile("a(b|cd)*e?f+");
+  ASSERT_TRUE(dfa.Accepts("af"));
+  ASSERT_TRUE(dfa.Accepts("abcdbeff"));
+  ASSERT_FALSE(dfa.Accepts("a"));
+  ASSERT_FALSE(dfa.Accepts("acf"));
+  ASSERT_FALSE(dfa.Accepts("aeef"));
+
+  auto empty = Compile("");
+  ASSERT_TRUE(empty.Accepts(""));
+  ASSERT_FALSE(empty.Accepts("a"));
+
+  auto alternate_empty = Compile("a|");
+  ASSERT_TRUE(alternate_empty.Accepts(""));
+  ASSERT_TRUE(alternate_empty.Accepts("a"));
+}
+
+TEST(RegexToNfa, Classes) {
+  auto dfa = Compile("[a-c_][^0-9\\n]\\d\\x41.");
+  ASSERT_TRUE(dfa.Accepts("bx1Az"));
+  ASSERT_TRUE(dfa.Accepts("__9A "));
+  ASSERT_FALSE(dfa.Accepts("dx1Az"));
+  ASSERT_FALSE(dfa.Accepts("b51Az"));
+  ASSERT_FALSE(dfa.Accepts("bx1A\n"));
+
+  auto literal = Compile("[]a-][\\]]\\.\\*");
+  ASSERT_TRUE(literal.Accepts("-].*"));
+  ASSERT_TRUE(literal.Accepts("]].*"));
+  ASSERT_FALSE(literal.Accepts("b].*"));
+
+  auto escaped_range = Compile("[\\x30-\\x39][\\t-\\r]");
+  ASSERT_TRUE(escaped_range.Accepts("5\v"));
+  ASSERT_FALSE(escaped_range.Accepts("a\v"));
+  ASSERT_FALSE(escaped_range.Accepts("-\v"));
+  auto all_bytes = ByteSet{};
+  all_bytes.Invert();
+  ASSERT_EQ(CompileGlushkov("[\\x00-\\xff]").bytes[1], all_bytes);
+}
+
+TEST(RegexToNfa, BoundedRepeat) {
+  auto exact = Compile("(ab){2}");
+  ASSERT_TRUE(exact.Accepts("abab"));
+  ASSERT_FALSE(exact.Accepts("ab"));
+  ASSERT_FALSE(exact.Accepts("ababab"));
+
+  auto range = Compile("a{1,3}b");
+  ASSERT_FALSE(range.Accepts("b"));
+  ASSERT_TRUE(range.Accepts("ab"));
+  ASSERT_TRUE(range.Accepts("aaab"));
+  ASSERT_FALSE(range.Accepts("aaaab"));
+
+  auto at_least = Compile("a{2,}");
+  ASSERT_FALSE(at_least.Accepts("a"));
+  ASSERT_TRUE(at_least.Accepts("aaaaa"));
+
+  auto zero = Compile("xa{0}");
+  ASSERT_TRUE(zero.Accepts("x"));
+  ASSERT_FALSE(zero.Accepts("xa"));
+}
+
+TEST(RegexToNfa, SyntaxError) {
+  for (auto pattern : {"(a", "a)", "*a", "a{2", "a{3,1}", "[a", "[z-a]",
+                       "\\x4", "^a", "a{1001}"}) {
+    ASSERT_THROW(RegexToNfa(pattern), RegexError) << pattern;
+  }
+
+  try {
+    [[maybe_unused]] auto nfa = RegexToNfa("ab)");
+    FAIL();
+  } catch (const RegexError &e) {
+    ASSERT_EQ(e.GetPosition(), 2);
+  }
+}
@@ -0,0 +1,61 @@
+// clang-format off
+#define REGEX_FA_STATS
+#include "test.h"
+// clang-format on
+
+#include <thread>
+
+#include "regex-fa/nfa.hpp"
+#include "regex-fa/regex.hpp"
+#include "regex-fa/stats.hpp"
+
+using namespace regex_fa;
+
+TEST(Stats, Counters) {
+  Stats::Reset();
+  const auto nfa = RegexToNfa("(a|b)*a(a|b){3}");
+  const auto dfa = nfa.ToDfa();
+  const auto min_dfa = dfa.Minimize();
+  const auto stats = Stats::Read();
+
+  EXPECT_EQ(stats.Get(StatCounter::kSubsetsCreated), dfa.GetDfaTable().size());
+  EXPECT_EQ(stats.Get(StatCounter::kPeakSubsets), dfa.GetDfaTable().size());
+  EXPECT_EQ(stats.Get(StatCounter::kPeakBlocks), min_dfa.GetDfaTable().size());
+  EXPECT_GT(stats.Get(StatCounter::kSplits), 0);
+  EXPECT_GT(stats.Get(StatCounter::kRefinementRounds), 0);
+  EXPECT_GT(stats.Get(StatCounter::kBytesAllocated), 0);
+  for (auto phase :
+       {StatPhase::kRegexToNfa, StatPhase::kToDfa, StatPhase::kMinimize}) {
+    EXPECT_GT(stats.Get(phase).count(), 0);
+  }
+
+  Stats::Reset();
+  EXPECT_EQ(Stats::Read().Get(StatCounter::kSubsetsCreated), 0);
+}
+
+TEST(Stats, Threads) {
+  const auto nfa = RegexToNfa("(a|b)*a(a|b){5}");
+  const auto dfa = nfa.ToDfa();
+  const auto expected = dfa.GetDfaTable().size();
+  const auto expected_min = dfa.Minimize().GetDfaTable().size();
+  Stats::Reset();
+
+  // Counters of exited threads are kept, peaks are not summed.
+  auto threads = std::vector<std::thread>{};
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&nfa] { static_cast<void>(nfa.ToDfa()); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto stats = Stats::Read();
+  EXPECT_EQ(stats.Get(StatCounter::kSubsetsCreated), 3 * expected);
+  EXPECT_EQ(stats.Get(StatCounter::kPeakSubsets), expected);
+
+  Stats::Reset();
+  static_cast<void>(nfa.ToDfa(4).Minimize(4));
+  stats = Stats::Read();
+  EXPECT_EQ(stats.Get(StatCounter::kSubsetsCreated), expected);
+  EXPECT_EQ(stats.Get(StatCounter::kPeakBlocks), expected_min);
+  EXPECT_GT(stats.Get(StatCounter::kRefinementRounds), 0);
+}
@@ -86,8 +86,9 @@ inline std::string DfaMinimize(const std::string& args) {
   const auto json_args = json::parse(args);
   const auto flatDfa = json_args.get<FlatDfa>();
   const auto dfa = Dfa{flatDfa};
-  const auto res_dfa = dfa.Minimize();
-  const json res_json = DfaLogger::GetInstance().hopcroft_log;
+  auto logger = DfaLogger{};
+  const auto res_dfa = dfa.Minimize(logger);
+  const json res_json = logger.hopcroft_log;
   return res_json.dump();
 }
 
@@ -47,8 +47,9 @@ inline std::string NFaToDfa(const std::string& args) {
   const auto json_args = json::parse(args);
   const auto flatNfa = json_args.get<FlatNfa>();
   const auto nfa = Nfa{flatNfa};
-  const auto res_dfa = nfa.ToDfa();
-  const json res_json = NfaLogger::GetInstance().sc_log;
+  auto logger = NfaLogger{};
+  const auto res_dfa = nfa.ToDfa(logger);
+  const json res_json = logger.sc_log;
   return res_json.dump();
 }
 }  // namespace regex_fa